@@ -0,0 +1,80 @@
+#include "../src/hittable/hittable_list/hittable_list.h"
+#include "../src/hittable/bvh_node/bvh_node.h"
+#include "../src/hittable/sphere/sphere.h"
+#include "../src/hittable/sphere_soa/sphere_soa.h"
+#include "../src/material/matte/matte.h"
+
+/*
+  Traversal cost vs. scene size: linear scan through hittable_list and through the flat sphere_soa, compared to bvh_node
+  (closest hit, and any-hit occlusion queries).
+  Scenes are N small spheres scattered uniformly in a cube; the same set of random rays is traced through both.
+  Usage: bvh-bench [ray_count]
+*/
+
+using namespace std;
+
+static vec3 random_vec(double min, double max) {
+    return vec3(random_double(min, max), random_double(min, max), random_double(min, max));
+}
+
+static double occluded_all(const hittable& world, const vector<ray>& rays, int& hits) {
+    hits = 0;
+    auto start_time = Time::now();
+    for (const ray& r : rays)
+        if (world.occluded(r, 0.001, infinity)) ++hits;
+    duration elapsed = Time::now() - start_time;
+    return elapsed.count();
+}
+
+static double trace_all(const hittable& world, const vector<ray>& rays, int& hits) {
+    hit_record rec;
+    hits = 0;
+    auto start_time = Time::now();
+    for (const ray& r : rays)
+        if (world.hit(r, 0.001, infinity, rec)) ++hits;
+    duration elapsed = Time::now() - start_time;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    int ray_count = argc > 1 ? atoi(argv[1]) : 100000;
+    const int max_linear_size = 10000;  // linear scan beyond this takes too long to be worth timing
+
+    material::ptr mat = make_shared<matte>(color(0.5));
+
+    vector<ray> rays;
+    rays.reserve(ray_count);
+    for (int i = 0; i < ray_count; ++i)
+        rays.push_back(ray(point3(0, 0, -60), unit_vector(random_vec(-1, 1) + vec3(0, 0, 1.5))));
+
+    cout << "objects,build_ms,bvh_ns_per_ray,bvh_any_ns_per_ray,linear_ns_per_ray,soa_ns_per_ray,speedup" << endl;
+    for (int n : {10, 100, 1000, 10000, 100000}) {
+        hittable_list world;
+        for (int i = 0; i < n; ++i)
+            world.add(make_shared<sphere>(random_vec(-50, 50), 0.5, mat));
+
+        auto build_start = Time::now();
+        hittable::ptr bvh = bvh_node::build(world);
+        duration build_time = Time::now() - build_start;
+
+        sphere_soa soa(world);
+
+        int bvh_hits = 0, any_hits = 0, linear_hits = 0, soa_hits = 0;
+        double bvh_secs = trace_all(*bvh, rays, bvh_hits);
+        double any_secs = occluded_all(*bvh, rays, any_hits);
+        double linear_secs = n <= max_linear_size ? trace_all(world, rays, linear_hits) : 0.0;
+        double soa_secs = n <= max_linear_size ? trace_all(soa, rays, soa_hits) : 0.0;
+
+        cout << n << ',' << build_time.count()*1e3 << ',' << bvh_secs/ray_count*1e9 << ',' << any_secs/ray_count*1e9 << ',';
+        if (n <= max_linear_size) {
+            cout << linear_secs/ray_count*1e9 << ',' << soa_secs/ray_count*1e9 << ',' << linear_secs/bvh_secs;
+            if (bvh_hits != linear_hits || soa_hits != linear_hits)
+                cerr << "Hit count mismatch at " << n << " objects: " << bvh_hits << ", " << soa_hits << " vs " << linear_hits << endl;
+        } else
+            cout << "-,-,-";
+        if (any_hits != bvh_hits)
+            cerr << "Occlusion count mismatch at " << n << " objects: " << any_hits << " vs " << bvh_hits << endl;
+        cout << endl;
+    }
+    return 0;
+}
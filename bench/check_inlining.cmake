@@ -0,0 +1,62 @@
+# Run by the check-inlining target: cmake -DOBJDUMP=<objdump> -DBINARY=<kernel-bench> -P check_inlining.cmake
+#
+# Disassembles BINARY and, for each hot kernel below, lists the functions it calls. The check fails if any of them is one
+# of the vec3/ray/aabb/hit_record helpers, i.e. the header-inline math did not get inlined. Calls that are expected to
+# stay calls (the RNG, virtual dispatch to child nodes) are not flagged. Also reports how many packed (vector) SIMD
+# instructions each kernel contains.
+
+set (kernels
+  "sphere::hit(" "sphere::occluded(" "bvh_node::hit(" "bvh_node::occluded(" "matte::scatter(" "metal::scatter(")
+set (helper_pattern "<(vec3::|ray::|aabb::hit|hit_record::set_face_normal|operator[-+*/^]+\\(vec3|dot\\(|cross\\(|unit_vector\\(|reflect\\(|sqrt\\(vec3)")
+
+set (listing "${CMAKE_CURRENT_BINARY_DIR}/kernel-bench.dis")
+execute_process (COMMAND ${OBJDUMP} -d -C --no-show-raw-insn ${BINARY} OUTPUT_FILE ${listing} RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+  message (FATAL_ERROR "objdump failed on ${BINARY}")
+endif()
+
+file (STRINGS ${listing} lines REGEX "^[0-9a-f]+ <|call|p[sd] ")
+
+set (failed FALSE)
+set (current "")
+foreach (line IN LISTS lines)
+  if (line MATCHES "^[0-9a-f]+ <(.*)>:$")
+    set (current "")
+    foreach (kernel IN LISTS kernels)
+      string (FIND "${CMAKE_MATCH_1}" "${kernel}" at)
+      if (at EQUAL 0)
+        set (current "${kernel}")
+        set (found_${current} TRUE)
+        set (packed_${current} 0)
+        set (calls_${current} "")
+      endif()
+    endforeach()
+  elseif (NOT current STREQUAL "")
+    if (line MATCHES "\tcall[q]? +(.*)$")
+      list (APPEND calls_${current} "${CMAKE_MATCH_1}")
+      if (line MATCHES "${helper_pattern}")
+        message (SEND_ERROR "${current}...) still calls ${CMAKE_MATCH_1}")
+        set (failed TRUE)
+      endif()
+    elseif (line MATCHES "\tv?[a-z0-9]+p[sd] ")
+      math (EXPR packed_${current} "${packed_${current}} + 1")
+    endif()
+  endif()
+endforeach()
+
+foreach (kernel IN LISTS kernels)
+  if (NOT found_${kernel})
+    message (SEND_ERROR "${kernel}...) not found in ${BINARY}")
+    set (failed TRUE)
+    continue()
+  endif()
+  list (LENGTH calls_${kernel} call_count)
+  message (STATUS "${kernel}...): ${packed_${kernel}} packed SIMD instructions, ${call_count} calls")
+  foreach (callee IN LISTS calls_${kernel})
+    message (STATUS "    calls ${callee}")
+  endforeach()
+endforeach()
+
+if (NOT failed)
+  message (STATUS "All kernels are free of vec3/ray/aabb helper calls")
+endif()
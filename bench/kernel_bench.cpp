@@ -0,0 +1,85 @@
+#include "../src/hittable/hittable_list/hittable_list.h"
+#include "../src/hittable/bvh_node/bvh_node.h"
+#include "../src/hittable/sphere/sphere.h"
+#include "../src/material/matte/matte.h"
+#include "../src/material/metal/metal.h"
+#include "../src/material/dielectric/dielectric.h"
+
+/*
+  Cost per call of the innermost kernels: ray-sphere intersection (closest hit and any hit), the aabb slab test, BVH
+  traversal, matte, metal and dielectric scattering, and a plain normalize loop over a vec3 array. These are the paths that rely on
+  the header-inline vec3 math; the check-inlining target confirms from the disassembly that none of them calls out.
+  Usage: kernel-bench [count]
+*/
+
+using namespace std;
+
+static vec3 random_vec(double min, double max) {
+    return vec3(random_double(min, max), random_double(min, max), random_double(min, max));
+}
+
+/* Times 'count' calls of f(i), returning nanoseconds per call. 'sink' keeps the results alive. */
+template <typename F>
+static double ns_per_call(int count, F f, double& sink) {
+    auto start_time = Time::now();
+    for (int i = 0; i < count; ++i) sink += f(i);
+    duration elapsed = Time::now() - start_time;
+    return elapsed.count() / count * 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    seed_random(1);
+
+    material::ptr diffuse = make_shared<matte>(color(0.5));
+    material::ptr shiny = make_shared<metal>(color(0.8), 0.2);
+    material::ptr glass = make_shared<dielectric>(1.5);
+    sphere ball(point3(0, 0, 0), 1, diffuse);
+
+    hittable_list world;
+    for (int i = 0; i < 1000; ++i)
+        world.add(make_shared<sphere>(random_vec(-20, 20), 0.5, diffuse));
+    hittable::ptr bvh = bvh_node::build(world);
+    aabb box(point3(-1), point3(1));
+
+    // Rays from a shell around the origin, aimed near the unit sphere so roughly half of them hit it
+    vector<ray> rays;
+    rays.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        point3 origin = 4 * random_unit_vector();
+        rays.push_back(ray(origin, unit_vector(random_vec(-1.2, 1.2) - origin)));
+    }
+
+    vector<hit_record> recs(count);
+    for (int i = 0; i < count; ++i)
+        if (!ball.hit(rays[i], 0.001, infinity, recs[i])) ball.hit(ray(rays[i].orig, -rays[i].orig), 0.001, infinity, recs[i]);
+
+    vector<vec3> vectors(count);
+    for (vec3& v : vectors) v = random_vec(-1, 1);
+
+    double sink = 0;
+    hit_record rec;
+    const hittable& ball_ref = ball;  // called through the base class, the way the renderer does
+    const material& diffuse_ref = *diffuse;
+    const material& shiny_ref = *shiny;
+    const material& glass_ref = *glass;
+
+    cout << "kernel,ns_per_call" << endl;
+    cout << "sphere_hit,"      << ns_per_call(count, [&](int i) { return ball_ref.hit(rays[i], 0.001, infinity, rec) ? rec.t : 0.0; }, sink) << endl;
+    cout << "sphere_occluded," << ns_per_call(count, [&](int i) { return ball_ref.occluded(rays[i], 0.001, infinity) ? 1.0 : 0.0; }, sink) << endl;
+    cout << "aabb_hit,"        << ns_per_call(count, [&](int i) { return box.hit(rays[i], 0.001, infinity) ? 1.0 : 0.0; }, sink) << endl;
+    cout << "bvh_hit_1k,"      << ns_per_call(count, [&](int i) { return bvh->hit(rays[i], 0.001, infinity, rec) ? rec.t : 0.0; }, sink) << endl;
+    cout << "matte_scatter,"   << ns_per_call(count, [&](int i) { return diffuse_ref.scatter(rays[i], recs[i]).dir.x(); }, sink) << endl;
+    cout << "metal_scatter,"   << ns_per_call(count, [&](int i) { return shiny_ref.scatter(rays[i], recs[i]).dir.x(); }, sink) << endl;
+    cout << "glass_scatter,"   << ns_per_call(count, [&](int i) { return glass_ref.scatter(rays[i], recs[i]).dir.x(); }, sink) << endl;
+
+    // Whole-array loop, which the compiler can vectorize once unit_vector is visible to it
+    auto start_time = Time::now();
+    for (vec3& v : vectors) v = unit_vector(v);
+    duration elapsed = Time::now() - start_time;
+    for (const vec3& v : vectors) sink += v.x();
+    cout << "normalize_array," << elapsed.count() / count * 1e9 << endl;
+
+    cerr << "checksum " << sink << endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "../src/camera/camera.h"
+#include "../src/hittable/hittable_list/hittable_list.h"
+#include "../src/hittable/sphere/sphere.h"
+#include "../src/hittable/sphere_soa/sphere_soa.h"
+#include "../src/material/matte/matte.h"
+
+#include <cstring>
+
+/*
+  First-hit cost of primary camera rays: one ray at a time through hittable_list of spheres vs. ray packets through sphere_soa.
+  Also checks that both paths produce bit-identical hit records.
+  Usage: packet-bench [grid_size]   (scene is the 4-sphere demo scene plus a grid_size x grid_size grid of small spheres)
+*/
+
+using namespace std;
+
+static bool same_bits(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool same_bits(const vec3& a, const vec3& b) {
+    return same_bits(a.x(), b.x()) && same_bits(a.y(), b.y()) && same_bits(a.z(), b.z());
+}
+
+int main(int argc, char* argv[]) {
+    int grid = argc > 1 ? atoi(argv[1]) : 8;
+    const int width = 640, height = 360, spp = 4;
+
+    double l = cos(3.14159/4);
+    camera cam(point3(1, 0, 0.1), point3(0, 0, -1), point3(l, 0.0, -1.0), y_hat(), 16.0/9.0, 70, 0.05);
+
+    material::ptr mat = make_shared<matte>(color(0.5));
+    hittable_list world;
+    world.add(make_shared<sphere>(point3( 0.0, -100.5*l, -1.0), 100.0*l, mat));
+    world.add(make_shared<sphere>(point3( 0.0,    0.0, -1.0),   0.45*l, mat));
+    world.add(make_shared<sphere>(point3(-l,    0.0, -1.0),   0.5*l, mat));
+    world.add(make_shared<sphere>(point3( l,    0.0, -1.0),   0.5*l, mat));
+    for (int a = 0; a < grid; ++a)
+        for (int b = 0; b < grid; ++b)
+            world.add(make_shared<sphere>(point3(-2.0 + 4.0*a/grid, -0.3, -1.5 - 3.0*b/grid), 0.08, mat));
+
+    sphere_soa soa(world);
+
+    vector<ray> rays;
+    seed_random(1);
+    for (int i = 0; i < height; ++i)
+        for (int j = 0; j < width; ++j)
+            for (int k = 0; k < spp; ++k)
+                rays.push_back(cam.get_ray((j + random_double())/width, (i + random_double())/height));
+
+    // Single rays
+    vector<hit_record> scalar_recs(rays.size());
+    vector<bool> scalar_hit(rays.size());
+    auto start_time = Time::now();
+    for (size_t n = 0; n < rays.size(); ++n)
+        scalar_hit[n] = world.hit(rays[n], 0.001, infinity, scalar_recs[n]);
+    duration scalar_time = Time::now() - start_time;
+
+    // Packets
+    vector<packet_hit> packet_hits(rays.size() / ray_packet::size);
+    start_time = Time::now();
+    for (size_t p = 0; p < packet_hits.size(); ++p) {
+        ray_packet rp;
+        for (int lane = 0; lane < ray_packet::size; ++lane)
+            rp.set(lane, rays[p*ray_packet::size + lane]);
+        soa.hit_packet(rp, 0.001, infinity, packet_hits[p]);
+    }
+    duration packet_time = Time::now() - start_time;
+
+    // Compare hit records
+    size_t mismatches = 0;
+    for (size_t n = 0; n < packet_hits.size()*ray_packet::size; ++n) {
+        const packet_hit& ph = packet_hits[n / ray_packet::size];
+        int lane = n % ray_packet::size;
+        bool packet_hit_anything = ph.index[lane] >= 0;
+        if (packet_hit_anything != scalar_hit[n]) { ++mismatches; continue; }
+        if (!packet_hit_anything) continue;
+
+        hit_record rec;
+        soa.finalize_hit(rays[n], ph.index[lane], ph.t[lane], rec);
+        const hit_record& ref = scalar_recs[n];
+        if (!same_bits(rec.t, ref.t) || !same_bits(rec.p, ref.p) || !same_bits(rec.normal, ref.normal) || rec.is_front_face != ref.is_front_face)
+            ++mismatches;
+    }
+
+    cout << "SIMD path:      " << sphere_soa::simd_path() << endl;
+    cout << "Spheres:        " << soa.radius.size() << endl;
+    cout << "Primary rays:   " << rays.size() << endl;
+    cout << "Single ray:     " << scalar_time.count()/rays.size()*1e9 << " ns/ray" << endl;
+    cout << "Packet:         " << packet_time.count()/rays.size()*1e9 << " ns/ray" << endl;
+    cout << "Speedup:        " << scalar_time.count()/packet_time.count() << "x" << endl;
+    cout << "Mismatches:     " << mismatches << endl;
+
+    // The packet kernel always works in double, so a float build can only agree to float precision
+    if (sizeof(real) != sizeof(double)) {
+        cout << "(float build: hit records are not expected to be bit-identical)" << endl;
+        return 0;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,351 @@
+#include "../src/renderer/renderer.h"
+#include "../src/hittable/sphere/sphere.h"
+#include "../src/material/matte/matte.h"
+#include "../src/material/metal/metal.h"
+#include "../src/material/dielectric/dielectric.h"
+#include "../src/material/emissive/emissive.h"
+
+#include <cstring>
+#include <sstream>
+
+/*
+  End-to-end render benchmark over a fixed set of scenes, for tracking performance between builds.
+  Scenes are generated from fixed seeds and rendered with a fixed renderer seed, so ray counts are identical from run to run
+  (and across thread counts); only the timings change. Results are printed as JSON on stdout, including where paths end
+  per bounce (escaped, Russian roulette, or cut off by the bounce depth).
+  Usage: rt-bench [--scene name[,name...]] [--threads n[,n...]] [--width w] [--spp n] [--depth d] [--roulette threshold] [--packets] [--wavefront] [--no-nee]
+                  [--sampler random|sobol] [--denoise] [--save prefix] [--reference prefix]
+    scenes:    four_spheres, book_cover, stress_100k, glass_heavy, small_light (default: all)
+    threads:   default is 1, 2, 4, ... up to the hardware thread count
+    packets:   trace primary rays in SIMD packets; they skip the BVH, so stress_100k gets much slower with them
+    sampler:   where pixel samples come from, see renderer::sampling (default: sobol)
+    denoise:   run the denoiser over the last run's image before saving or comparing it, and report its time
+    save:      write each scene's render to <prefix><scene>.pfm
+    reference: compare each scene's render against <prefix><scene>.pfm and report the error
+
+  Comparing precisions: render with the double build and --save, then run the float build (-DRT_USE_FLOAT=ON) with the
+  same settings and --reference pointing at those files. The timings show the speed difference, image_error the cost.
+  Comparing samplers works the same way: --save a high spp render, then --reference it at low spp with each --sampler
+  (or with --denoise).
+*/
+
+using namespace std;
+
+struct bench_scene {
+    string name;
+    hittable_list world;
+    camera cam;
+    color background = color(1,1,1);
+};
+
+static vec3 random_vec(double min, double max) {
+    return vec3(random_double(min, max), random_double(min, max), random_double(min, max));
+}
+
+/* The demo scene from main.cpp */
+static bench_scene four_spheres(double aspect) {
+    bench_scene s;
+    s.name = "four_spheres";
+    double l = cos(3.14159/4);
+    s.cam = camera(point3(1, 0, 0.1), point3(0, 0, -1), point3(l, 0.0, -1.0), y_hat(), aspect, 70, 0.05);
+
+    s.world.add(make_shared<sphere>(point3( 0.0, -100.5*l, -1.0), 100.0*l, make_shared<matte>(color(0.8, 0.8, 0.0))));
+    s.world.add(make_shared<sphere>(point3( 0.0,    0.0, -1.0),   0.45*l, make_shared<matte>(color(0.4))));
+    s.world.add(make_shared<sphere>(point3(-l,    0.0, -1.0),   0.5*l, make_shared<metal>(color(0.8, 0.8, 0.8), 0.1)));
+    s.world.add(make_shared<sphere>(point3( l,    0.0, -1.0),   0.5*l, make_shared<metal>(color(0.8, 0.6, 0.2), 0.2)));
+    return s;
+}
+
+/* Final scene of Ray Tracing in One Weekend: a 22 x 22 grid of small random spheres around three big ones */
+static bench_scene book_cover(double aspect) {
+    bench_scene s;
+    s.name = "book_cover";
+    s.cam = camera(point3(13, 2, 3), point3(0, 0, 0), point3(4, 1, 0), y_hat(), aspect, 20, 0.1);
+
+    seed_random(1);
+    s.world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<matte>(color(0.5))));
+    for (int a = -11; a < 11; ++a) {
+        for (int b = -11; b < 11; ++b) {
+            double choose_mat = random_double();
+            point3 center(a + 0.9*random_double(), 0.2, b + 0.9*random_double());
+            if ((center - point3(4, 0.2, 0)).length() <= 0.9) continue;
+
+            material::ptr mat;
+            if (choose_mat < 0.8)
+                mat = make_shared<matte>(random_vec(0, 1) * random_vec(0, 1));
+            else if (choose_mat < 0.95)
+                mat = make_shared<metal>(random_vec(0.5, 1), random_double(0, 0.5));
+            else
+                mat = make_shared<dielectric>(1.5);
+            s.world.add(make_shared<sphere>(center, 0.2, mat));
+        }
+    }
+    s.world.add(make_shared<sphere>(point3( 0, 1, 0), 1.0, make_shared<dielectric>(1.5)));
+    s.world.add(make_shared<sphere>(point3(-4, 1, 0), 1.0, make_shared<matte>(color(0.4, 0.2, 0.1))));
+    s.world.add(make_shared<sphere>(point3( 4, 1, 0), 1.0, make_shared<metal>(color(0.7, 0.6, 0.5), 0.0)));
+    return s;
+}
+
+/* 100,000 small spheres resting on a ground plane, seen at a grazing angle: stresses BVH build and traversal */
+static bench_scene stress_100k(double aspect) {
+    bench_scene s;
+    s.name = "stress_100k";
+    s.cam = camera(point3(0, 8, 40), point3(0, 0, 0), point3(0, 0, 0), y_hat(), aspect, 40, 0.0);
+
+    seed_random(2);
+    material::ptr mats[] = {
+        make_shared<matte>(color(0.7, 0.3, 0.3)),
+        make_shared<matte>(color(0.3, 0.7, 0.3)),
+        make_shared<metal>(color(0.8), 0.3),
+        make_shared<dielectric>(1.5)
+    };
+    s.world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<matte>(color(0.5))));
+    for (int i = 0; i < 100000; ++i) {
+        point3 center(random_double(-50, 50), 0.15, random_double(-50, 50));
+        s.world.add(make_shared<sphere>(center, 0.15, mats[(int) (random_double() * 4) & 3]));
+    }
+    return s;
+}
+
+/* Rows of solid and hollow glass spheres in front of a few colored ones: long refraction paths */
+static bench_scene glass_heavy(double aspect) {
+    bench_scene s;
+    s.name = "glass_heavy";
+    s.cam = camera(point3(0, 1.5, 6), point3(0, 0.5, 0), point3(0, 0.5, 0), y_hat(), aspect, 45, 0.0);
+
+    material::ptr glass = make_shared<dielectric>(1.5);
+    s.world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<matte>(color(0.6))));
+    for (int a = -3; a <= 3; ++a) {
+        for (int b = -3; b <= 0; ++b) {
+            point3 center(0.9*a, 0.4, 0.9*b);
+            s.world.add(make_shared<sphere>(center, 0.4, glass));
+            if ((a + b) % 2 == 0)
+                s.world.add(make_shared<sphere>(center, -0.35, glass));  // hollow shell
+        }
+    }
+    s.world.add(make_shared<sphere>(point3(-1.5, 0.8, -5), 0.8, make_shared<matte>(color(0.8, 0.2, 0.2))));
+    s.world.add(make_shared<sphere>(point3( 0.0, 0.8, -5), 0.8, make_shared<matte>(color(0.2, 0.8, 0.2))));
+    s.world.add(make_shared<sphere>(point3( 1.5, 0.8, -5), 0.8, make_shared<matte>(color(0.2, 0.2, 0.8))));
+    return s;
+}
+
+static string json_array(const vector<uint64_t>& values) {
+    stringstream out;
+    out << "[";
+    for (size_t i = 0; i < values.size(); ++i) out << (i ? ", " : "") << values[i];
+    out << "]";
+    return out.str();
+}
+
+/* A few spheres in a closed room lit only by one small bright sphere: needs light sampling to converge */
+static bench_scene small_light(double aspect) {
+    bench_scene s;
+    s.name = "small_light";
+    s.background = color(0,0,0);
+    s.cam = camera(point3(0, 1, 4.5), point3(0, 1, 0), point3(0, 1, 0), y_hat(), aspect, 50, 0.0);
+
+    s.world.add(make_shared<sphere>(point3(0, 1, 0), -6.0, make_shared<matte>(color(0.7))));  // room, seen from inside
+    s.world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, make_shared<matte>(color(0.6, 0.6, 0.5))));
+    s.world.add(make_shared<sphere>(point3(-1.2, 0.6, 0), 0.6, make_shared<matte>(color(0.8, 0.3, 0.2))));
+    s.world.add(make_shared<sphere>(point3( 0.0, 0.6, -0.8), 0.6, make_shared<metal>(color(0.9), 0.05)));
+    s.world.add(make_shared<sphere>(point3( 1.2, 0.6, 0), 0.6, make_shared<dielectric>(1.5)));
+    s.world.add(make_shared<sphere>(point3(0.5, 3.0, 1.0), 0.15, make_shared<emissive>(color(400))));
+    return s;
+}
+
+/* Reads a little-endian PFM as written by write_image, flipped back to top-to-bottom rows. Empty on failure. */
+static vector<float> read_pfm(const string& filename, int width, int height) {
+    ifstream in(filename, ios::binary);
+    string magic;
+    int w = 0, h = 0;
+    double scale = 0;
+    in >> magic >> w >> h >> scale;
+    in.get();
+    if (!in || magic != "PF" || w != width || h != height || scale >= 0) return {};
+
+    vector<float> rows(3*size_t(w)*h), out(rows.size());
+    in.read(reinterpret_cast<char*>(rows.data()), rows.size()*sizeof(float));
+    if (!in) return {};
+    for (int y = 0; y < h; ++y)
+        copy_n(rows.begin() + 3*size_t(w)*(h - 1 - y), 3*w, out.begin() + 3*size_t(w)*y);
+    return out;
+}
+
+/* RMSE and largest channel difference between a render and a reference image, plus the RMSE relative to the reference's
+   mean. display_rmse compares what would be shown (clamped to [0,1], gamma 2), where the odd firefly counts for less. */
+static string image_error(const image& img, const vector<float>& reference) {
+    double sum_sq = 0, max_abs = 0, sum_ref = 0, display_sq = 0;
+    auto display = [](double v) { return sqrt(min(max(v, 0.0), 1.0)); };
+    for (int i = 0; i < img.width*img.height; ++i) {
+        color c = img.accum.mean(i);
+        for (int k = 0; k < 3; ++k) {
+            double d = c[k] - reference[3*size_t(i) + k];
+            sum_sq += d*d;
+            max_abs = max(max_abs, fabs(d));
+            sum_ref += reference[3*size_t(i) + k];
+            double dd = display(c[k]) - display(reference[3*size_t(i) + k]);
+            display_sq += dd*dd;
+        }
+    }
+    double n = 3.0*img.width*img.height;
+    double rmse = sqrt(sum_sq / n);
+    stringstream ss;
+    ss << "{\"rmse\": " << rmse << ", \"relative_rmse\": " << rmse / max(sum_ref / n, 1e-12) << ", \"max_abs\": " << max_abs
+       << ", \"display_rmse\": " << sqrt(display_sq / n) << "}";
+    return ss.str();
+}
+
+static vector<string> split(const string& list) {
+    vector<string> out;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ',')) out.push_back(item);
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    int width = 320, spp = 16, depth = 50;
+    double roulette = renderer().roulette_threshold;
+    bool packets = false, wavefront = false, nee = true, denoise = false;
+    sample_pattern sampling = sample_pattern::SOBOL;
+    string save_prefix, reference_prefix;
+    vector<string> scene_names = {"four_spheres", "book_cover", "stress_100k", "glass_heavy", "small_light"};
+    vector<int> thread_counts;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--scene" && has_value) scene_names = split(argv[++i]);
+        else if (arg == "--threads" && has_value) for (const string& t : split(argv[++i])) thread_counts.push_back(stoi(t));
+        else if (arg == "--width" && has_value) width = atoi(argv[++i]);
+        else if (arg == "--spp" && has_value) spp = atoi(argv[++i]);
+        else if (arg == "--depth" && has_value) depth = atoi(argv[++i]);
+        else if (arg == "--roulette" && has_value) roulette = atof(argv[++i]);
+        else if (arg == "--packets") packets = true;
+        else if (arg == "--wavefront") wavefront = true;
+        else if (arg == "--no-nee") nee = false;
+        else if (arg == "--denoise") denoise = true;
+        else if (arg == "--sampler" && has_value) {
+            string name = argv[++i];
+            if (name == "random") sampling = sample_pattern::RANDOM;
+            else if (name == "sobol") sampling = sample_pattern::SOBOL;
+            else {
+                cerr << "Unknown sampler '" << name << "'" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--save" && has_value) save_prefix = argv[++i];
+        else if (arg == "--reference" && has_value) reference_prefix = argv[++i];
+        else {
+            cerr << "Unknown or incomplete argument '" << arg << "'" << endl;
+            return 1;
+        }
+    }
+    if (thread_counts.empty()) {
+        int hw = max((int) thread::hardware_concurrency(), 1);
+        for (int t = 1; t < hw; t *= 2) thread_counts.push_back(t);
+        thread_counts.push_back(hw);
+    }
+
+    const double aspect = 16.0/9.0;
+    const int height = (int) (width / aspect);
+
+    cout << "{" << endl;
+    cout << "  \"settings\": {\"width\": " << width << ", \"height\": " << height << ", \"spp\": " << spp
+         << ", \"depth\": " << depth << ", \"roulette_threshold\": " << roulette << ", \"seed\": 0, \"packets\": " << (packets ? "true" : "false")
+         << ", \"sampler\": \"" << (sampling == sample_pattern::SOBOL ? "sobol" : "random") << "\""
+         << ", \"simd\": \"" << sphere_soa::simd_path() << "\", \"precision\": \"" << (sizeof(real) == sizeof(float) ? "float" : "double")
+         << "\"}," << endl;
+    cout << "  \"scenes\": [";
+
+    bool first_scene = true;
+    for (const string& name : scene_names) {
+        bench_scene s;
+        if (name == "four_spheres") s = four_spheres(aspect);
+        else if (name == "book_cover") s = book_cover(aspect);
+        else if (name == "stress_100k") s = stress_100k(aspect);
+        else if (name == "glass_heavy") s = glass_heavy(aspect);
+        else if (name == "small_light") s = small_light(aspect);
+        else {
+            cerr << "Unknown scene '" << name << "'" << endl;
+            return 1;
+        }
+
+        renderer r;
+        r.world = s.world;
+        r.cam = s.cam;
+        r.background = s.background;
+        r.image_width = width;
+        r.image_height = height;
+        r.samples_per_pixel = spp;
+        r.bounce_depth = depth;
+        r.roulette_threshold = roulette;
+        r.wavefront = wavefront;
+        r.next_event_estimation = nee;
+        r.sampling = sampling;
+        r.denoise = denoise;
+        r.seed = 0;
+        r.progress_callback = nullptr;
+
+        auto build_start = Time::now();
+        r.build_bvh();
+        duration build_time = Time::now() - build_start;
+        if (packets) r.enable_packet_tracing();
+
+        cout << (first_scene ? "" : ",") << endl;
+        first_scene = false;
+        cout << "    {\"name\": \"" << s.name << "\", \"objects\": " << s.world.h_list.size()
+             << ", \"bvh_build_ms\": " << build_time.count()*1e3 << "," << endl;
+
+        ray_stats rays = {0, 0, 0};
+        path_stats paths;
+        double base_seconds = 0.0;
+        stringstream runs;
+        image pixels(width, height);
+        if (r.records_features()) pixels.aov.allocate();
+        for (size_t k = 0; k < thread_counts.size(); ++k) {
+            r.core_count = thread_counts[k];
+            r.reset_ray_counts();
+            pixels.clear();
+
+            auto start_time = Time::now();
+            r.render_to_image(pixels);
+            duration elapsed = Time::now() - start_time;
+
+            rays = r.ray_counts();
+            paths = r.path_counts();
+            double seconds = elapsed.count();
+            if (k == 0) base_seconds = seconds * thread_counts[0];
+            double speedup = base_seconds / seconds;
+
+            runs << (k ? "," : "") << endl
+                 << "        {\"threads\": " << thread_counts[k] << ", \"seconds\": " << seconds
+                 << ", \"mrays_per_s\": " << (rays.primary + rays.secondary + rays.shadow) / seconds * 1e-6
+                 << ", \"ms_per_spp\": " << seconds / spp * 1e3
+                 << ", \"speedup\": " << speedup << ", \"efficiency\": " << speedup / thread_counts[k] << "}";
+        }
+
+        cout << "     \"primary_rays\": " << rays.primary << ", \"secondary_rays\": " << rays.secondary
+             << ", \"shadow_rays\": " << rays.shadow << "," << endl;
+        cout << "     \"rays_per_bounce\": " << json_array(paths.rays) << "," << endl;
+        cout << "     \"escaped_per_bounce\": " << json_array(paths.escaped) << "," << endl;
+        cout << "     \"roulette_per_bounce\": " << json_array(paths.roulette) << "," << endl;
+        cout << "     \"depth_limited\": " << paths.depth_limited << "," << endl;
+
+        // Renders are deterministic, so the last run's image stands for all of them
+        if (denoise) {
+            auto start_time = Time::now();
+            r.denoise_image(pixels);
+            cout << "     \"denoise_ms\": " << duration(Time::now() - start_time).count()*1e3 << "," << endl;
+        }
+        if (!save_prefix.empty()) write_image(save_prefix + s.name + ".pfm", pixels, image_format::PFM);
+        if (!reference_prefix.empty()) {
+            vector<float> reference = read_pfm(reference_prefix + s.name + ".pfm", width, height);
+            if (reference.empty()) cerr << "Could not read reference image '" << reference_prefix + s.name + ".pfm'" << endl;
+            else cout << "     \"image_error\": " << image_error(pixels, reference) << "," << endl;
+        }
+        cout << "     \"runs\": [" << runs.str() << endl << "     ]}";
+    }
+    cout << endl << "  ]" << endl << "}" << endl;
+    return 0;
+}
@@ -2,7 +2,7 @@
 
 camera::camera() {}
 
-camera::camera(point3 lookfrom, point3 look_at, point3 focusat, vec3 vup, double aspr, double yfov, double aperature) {
+camera::camera(point3 lookfrom, point3 look_at, point3 focusat, vec3 vup, real aspr, real yfov, real aperature) {
   aspect_ratio = aspr;
   y_fov = yfov;
   lens_radius = aperature/2;
@@ -22,7 +22,7 @@ void camera::orient(point3 lookfrom, point3 lookat, vec3 vup) {
 }
 
 /* For a simple pan (horizontal movement), everything remains the same except origin and lower_left_corner. */
-void camera::pan(vec3 direction, double pan_amount) {
+void camera::pan(vec3 direction, real pan_amount) {
   direction = unit_vector(direction);
   origin += direction*pan_amount;
   set_imageplane_vecs();
@@ -55,7 +55,7 @@ void camera::set_focus_distance(point3 focusat) {
 }
 
 void camera::set_viewport_specs() {
-  double h = std::tan(degrees_to_radians(y_fov)/2.0)*focus_dist;
+  real h = std::tan(degrees_to_radians(y_fov)/2.0)*focus_dist;
   viewport_height = 2.0*h;
   viewport_width = aspect_ratio * viewport_height;
 }
@@ -67,15 +67,14 @@ void camera::set_imageplane_vecs() {
   top_left_corner = lower_left_corner + vertical;
 }
 
+/* Uniform point on the lens disk, spanned by the camera's x and y axes */
 vec3 camera::random_in_unit_disk() const {
-  while (true) {
-    vec3 v = random_double()*x + random_double()*y;
-    if (v.length_squared() < 1) return v;
-  }
+  point3 p = ::random_in_unit_disk();
+  return p.x()*x + p.y()*y;
 }
 
 /* u, v are real numbers b/w 0 and 1. Width and height of the viewport represented as a percentage. */
-ray camera::get_ray(double u, double v) const {
+ray camera::get_ray(real u, real v) const {
   vec3 rd = origin + lens_radius*random_in_unit_disk();
   return ray(rd, (top_left_corner + u*horizontal - v*vertical) - rd);
 }
\ No newline at end of file
@@ -3,12 +3,12 @@
 class camera {
   public:
     camera();
-    camera(point3 lookfrom, point3 look_at, point3 focusat, vec3 vup, double aspr, double yfov, double aperature);
+    camera(point3 lookfrom, point3 look_at, point3 focusat, vec3 vup, real aspr, real yfov, real aperature);
 
     void orient(point3 lookfrom, point3 lookat, vec3 vup);
     void focus(point3 focusat);
-    void pan(vec3 direction, double pan_amount);
-    ray get_ray(double u, double v) const;
+    void pan(vec3 direction, real pan_amount);
+    ray get_ray(real u, real v) const;
 
   private:
     void set_basis(point3 lookfrom, point3 lookat, vec3 vup);
@@ -18,21 +18,21 @@ class camera {
     vec3 random_in_unit_disk() const;
 
   public:
-    double aspect_ratio;
+    real aspect_ratio;
     point3 origin;
     point3 lookat;
     vec3 y;
     point3 lower_left_corner;
     point3 top_left_corner;
-    double focus_dist;
+    real focus_dist;
     vec3 view_dir;
 
   private:
     vec3 x;
     vec3 horizontal;
     vec3 vertical;
-    double lens_radius;
-    double y_fov;
-    double viewport_height;
-    double viewport_width;
+    real lens_radius;
+    real y_fov;
+    real viewport_height;
+    real viewport_width;
 };
\ No newline at end of file
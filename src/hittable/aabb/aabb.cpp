@@ -0,0 +1,33 @@
+#include "aabb.h"
+
+aabb::aabb(): minimum(infinity), maximum(-infinity) {}
+
+aabb::aabb(const point3& a, const point3& b): minimum(a), maximum(b) {}
+
+point3 aabb::centroid() const {
+  return 0.5*(minimum + maximum);
+}
+
+real aabb::surface_area() const {
+  if (is_empty()) return 0.0;
+  vec3 d = maximum - minimum;
+  return 2*(d.x()*d.y() + d.y()*d.z() + d.z()*d.x());
+}
+
+bool aabb::is_empty() const {
+  return minimum.x() > maximum.x() || minimum.y() > maximum.y() || minimum.z() > maximum.z();
+}
+
+aabb surrounding_box(const aabb& box0, const aabb& box1) {
+  point3 small(std::min(box0.minimum.x(), box1.minimum.x()),
+               std::min(box0.minimum.y(), box1.minimum.y()),
+               std::min(box0.minimum.z(), box1.minimum.z()));
+  point3 big(std::max(box0.maximum.x(), box1.maximum.x()),
+             std::max(box0.maximum.y(), box1.maximum.y()),
+             std::max(box0.maximum.z(), box1.maximum.z()));
+  return aabb(small, big);
+}
+
+aabb surrounding_box(const aabb& box, const point3& p) {
+  return surrounding_box(box, aabb(p, p));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/* Axis-aligned bounding box, stored as its minimum and maximum corners. A default-constructed box is empty
+   (min = +inf, max = -inf), so it can be grown with surrounding_box() without special-casing the first object. */
+class aabb {
+  public:
+    aabb();
+    aabb(const point3& a, const point3& b);
+
+    bool   hit(const ray& r, real t_min, real t_max) const;
+    point3 centroid()     const;
+    real surface_area() const;
+    bool   is_empty()     const;
+
+  public:
+    point3 minimum;
+    point3 maximum;
+};
+
+/* Slab test: clip the [t_min, t_max] interval against each pair of axis planes in turn. Inline, since BVH traversal
+   runs it for every node it visits. */
+inline bool aabb::hit(const ray& r, real t_min, real t_max) const {
+  for (int a = 0; a < 3; ++a) {
+    real inv_d = 1 / r.dir[a];
+    real t0 = (minimum[a] - r.orig[a]) * inv_d;
+    real t1 = (maximum[a] - r.orig[a]) * inv_d;
+    if (inv_d < 0.0) std::swap(t0, t1);
+    t_min = t0 > t_min ? t0 : t_min;
+    t_max = t1 < t_max ? t1 : t_max;
+    if (t_max < t_min) return false;
+  }
+  return true;
+}
+
+aabb surrounding_box(const aabb& box0, const aabb& box1);
+aabb surrounding_box(const aabb& box, const point3& p);
@@ -0,0 +1,133 @@
+#include "bvh_node.h"
+
+#include <algorithm>
+
+static aabb object_box(const hittable* h_object) {
+  aabb box;
+  if (!h_object->bounding_box(box))
+    std::cerr << "No bounding box in bvh_node constructor.\n";
+  return box;
+}
+
+static int bin_index(real centroid, real lo, real extent) {
+  int k = static_cast<int>(bvh_node::bin_count * ((centroid - lo) / extent));
+  return k < bvh_node::bin_count ? k : bvh_node::bin_count - 1;
+}
+
+bvh_node::bvh_node(): left(nullptr), right(nullptr) {}
+
+hittable::ptr bvh_node::build(const hittable_list& list) {
+  std::vector<build_object> objects;  // reordered while building
+  objects.reserve(list.h_list.size());
+  for (const hittable* h_object : list.h_list) {
+    aabb b = object_box(h_object);
+    objects.push_back({h_object, b, b.centroid()});
+  }
+
+  auto arena = std::make_shared<scene_arena>();
+  bvh_node* root = arena->make<bvh_node>(objects, 0, objects.size(), *arena);
+  return hittable::ptr(arena, root);  // shares ownership of the arena, points at the root
+}
+
+bvh_node::bvh_node(std::vector<build_object>& objects, size_t start, size_t end, scene_arena& arena): left(nullptr), right(nullptr) {
+  size_t span = end - start;
+  if (span == 0) return;  // empty box; never hit
+
+  aabb centroid_bounds;
+  for (size_t i = start; i < end; ++i) {
+    box = surrounding_box(box, objects[i].box);
+    centroid_bounds = surrounding_box(centroid_bounds, objects[i].centroid);
+  }
+
+  if (span == 1) {
+    left = right = objects[start].object;
+  } else if (span == 2) {
+    left = objects[start].object;
+    right = objects[start+1].object;
+  } else {
+    size_t mid = sah_split(objects, start, end, centroid_bounds);
+    // Single objects become direct children rather than one-object nodes
+    left  = (mid - start == 1) ? objects[start].object : arena.make<bvh_node>(objects, start, mid, arena);
+    right = (end - mid == 1)   ? objects[mid].object   : arena.make<bvh_node>(objects, mid, end, arena);
+  }
+}
+
+/* Bins object centroids along each axis and picks the bin boundary with the lowest SAH cost
+   (count_left*area_left + count_right*area_right). Partitions objects[start, end) around it and returns the split index. */
+size_t bvh_node::sah_split(std::vector<build_object>& objects, size_t start, size_t end, const aabb& centroid_bounds) {
+  real best_cost = infinity;
+  int best_axis = -1;
+  int best_bin = 0;
+
+  for (int axis = 0; axis < 3; ++axis) {
+    real lo = centroid_bounds.minimum[axis];
+    real extent = centroid_bounds.maximum[axis] - lo;
+    if (extent <= 0.0) continue;  // all centroids coincide along this axis
+
+    aabb bin_boxes[bin_count];
+    int  bin_counts[bin_count] = {0};
+    for (size_t i = start; i < end; ++i) {
+      int k = bin_index(objects[i].centroid[axis], lo, extent);
+      ++bin_counts[k];
+      bin_boxes[k] = surrounding_box(bin_boxes[k], objects[i].box);
+    }
+
+    // Sweep from the left, recording area & count of everything left of each boundary
+    real left_area[bin_count-1];
+    int    left_count[bin_count-1];
+    aabb acc;
+    int n = 0;
+    for (int k = 0; k < bin_count-1; ++k) {
+      acc = surrounding_box(acc, bin_boxes[k]);
+      n += bin_counts[k];
+      left_area[k] = acc.surface_area();
+      left_count[k] = n;
+    }
+
+    // Sweep from the right and evaluate the cost of splitting at each boundary
+    acc = aabb();
+    n = 0;
+    for (int k = bin_count-1; k > 0; --k) {
+      acc = surrounding_box(acc, bin_boxes[k]);
+      n += bin_counts[k];
+      if (left_count[k-1] == 0 || n == 0) continue;
+      real cost = left_count[k-1]*left_area[k-1] + n*acc.surface_area();
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = k;
+      }
+    }
+  }
+
+  // Degenerate case (all centroids in the same spot): any split is as good as another
+  if (best_axis == -1)
+    return start + (end - start)/2;
+
+  real lo = centroid_bounds.minimum[best_axis];
+  real extent = centroid_bounds.maximum[best_axis] - lo;
+  auto mid = std::partition(objects.begin() + start, objects.begin() + end, [&](const build_object& o) {
+    return bin_index(o.centroid[best_axis], lo, extent) < best_bin;
+  });
+  return mid - objects.begin();
+}
+
+bool bvh_node::hit(const ray& r, real t_min, real t_max, hit_record& rec) const {
+  if (!box.hit(r, t_min, t_max)) return false;
+
+  bool hit_left = left->hit(r, t_min, t_max, rec);
+  bool hit_right = right->hit(r, t_min, hit_left ? rec.t : t_max, rec);
+
+  return hit_left || hit_right;
+}
+
+/* Any-hit traversal: no closest t to track, so it returns as soon as either subtree reports a hit */
+bool bvh_node::occluded(const ray& r, real t_min, real t_max) const {
+  if (!box.hit(r, t_min, t_max)) return false;
+  return left->occluded(r, t_min, t_max) || right->occluded(r, t_min, t_max);
+}
+
+bool bvh_node::bounding_box(aabb& output_box) const {
+  output_box = box;
+  return true;
+}
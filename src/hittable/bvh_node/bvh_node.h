@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../hittable.h"
+#include "../hittable_list/hittable_list.h"
+
+/* Bounding volume hierarchy node. Each node bounds its two children, which are either further bvh_nodes or the scene
+   objects themselves. Splits are chosen with a binned surface area heuristic (SAH) over object centroids.
+   Nodes link to their children through plain pointers; all nodes of one tree live in a single scene_arena, which the
+   pointer returned by build() owns, so the whole tree is freed in one go. The scene objects are not owned: they must
+   outlive the tree. */
+class bvh_node : public hittable {
+  public:
+    struct build_object {  // an object with its bounds, computed once per build rather than at every level
+      const hittable* object;
+      aabb box;
+      point3 centroid;
+    };
+
+    bvh_node();
+    bvh_node(std::vector<build_object>& objects, size_t start, size_t end, scene_arena& arena);
+
+    static hittable::ptr build(const hittable_list& list);  // root of a new BVH over the objects of list
+
+    virtual bool hit(const ray& r, real t_min, real t_max, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, real t_min, real t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+
+  private:
+    static size_t sah_split(std::vector<build_object>& objects, size_t start, size_t end, const aabb& centroid_bounds);
+
+  public:
+    const hittable* left;
+    const hittable* right;
+    aabb box;
+
+    static const int bin_count = 12;
+};
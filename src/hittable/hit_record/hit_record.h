@@ -5,9 +5,12 @@
 struct hit_record {
   point3 p;
   vec3 normal;
-  double t;
-  material::ptr material_ptr;
+  real t;
+  const material* material_ptr;  // non-owning; the scene keeps materials alive for the duration of a render
   bool is_front_face;
 
-  void set_face_normal(const ray &r, const vec3 &outward_normal);
+  void set_face_normal(const ray &r, const vec3 &outward_normal) {
+    is_front_face = dot(r.direction(), outward_normal) < 0;
+    normal = is_front_face ? outward_normal : -outward_normal;
+  }
 };
\ No newline at end of file
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "hit_record/hit_record.h"
+#include "aabb/aabb.h"
 #include "../material/material.h"
 
 class hittable {
   public:
-    typedef std::shared_ptr<hittable> ptr;
+    typedef std::shared_ptr<hittable> ptr;                  // owning, for objects created one at a time
     typedef std::vector<ptr> ptr_list;
+    typedef std::vector<const hittable*> handle_list;      // non-owning; what lists and BVHs traverse
     
-    virtual bool hit(const ray &r, double t_min, double t_max, hit_record &rec) const = 0;
-};
\ No newline at end of file
+    virtual bool hit(const ray &r, real t_min, real t_max, hit_record &rec) const = 0;
+    virtual bool occluded(const ray& r, real t_min, real t_max) const = 0;  // any hit in [t_min, t_max]; stops at the first one found
+    virtual bool bounding_box(aabb& output_box) const = 0;  // returns false if object has no finite bounds
+};
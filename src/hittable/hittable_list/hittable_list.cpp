@@ -6,19 +6,28 @@ hittable_list::hittable_list(hittable::ptr h_object) {
   add(h_object);
 };
 
+hittable_list::hittable_list(scene_arena::ptr arena): arena(arena) {}
+
 void hittable_list::clear() {
   h_list.clear();
+  owned.clear();
+  arena.reset();
 }
 
 void hittable_list::add(hittable::ptr h_object) {
+  h_list.push_back(h_object.get());
+  owned.push_back(h_object);
+}
+
+void hittable_list::add(const hittable* h_object) {
   h_list.push_back(h_object);
 }
 
-bool hittable_list::hit(const ray& r, double t_min, double t_max, hit_record& rec) const {
+bool hittable_list::hit(const ray& r, real t_min, real t_max, hit_record& rec) const {
   hit_record temp_rec;
-  double t_closest = t_max;
+  real t_closest = t_max;
   bool hit_anything = false;
-  for (const hittable::ptr h_object : h_list) {
+  for (const hittable* h_object : h_list) {
     if (h_object->hit(r, t_min, t_closest, temp_rec)) {           
       hit_anything = true;
       t_closest = temp_rec.t;
@@ -26,4 +35,22 @@ bool hittable_list::hit(const ray& r, double t_min, double t_max, hit_record& re
     }
   }
   return hit_anything;
+}
+
+bool hittable_list::occluded(const ray& r, real t_min, real t_max) const {
+  for (const hittable* h_object : h_list)
+    if (h_object->occluded(r, t_min, t_max)) return true;
+  return false;
+}
+
+bool hittable_list::bounding_box(aabb& output_box) const {
+  if (h_list.empty()) return false;
+
+  aabb temp_box;
+  output_box = aabb();
+  for (const hittable* h_object : h_list) {
+    if (!h_object->bounding_box(temp_box)) return false;
+    output_box = surrounding_box(output_box, temp_box);
+  }
+  return true;
 }
\ No newline at end of file
@@ -1,17 +1,27 @@
 #pragma once
 
 #include "../hittable.h"
+#include "../../scene/scene_arena/scene_arena.h"
 
+/* Flat list of objects. Objects are traversed through non-owning handles; the list keeps them alive either by sharing
+   ownership (objects added as hittable::ptr) or by holding on to the scene_arena they were made in. */
 class hittable_list : public hittable {
   public:
     hittable_list();
     hittable_list(hittable::ptr h_object);
+    hittable_list(scene_arena::ptr arena);  // empty list for objects made in arena
 
     void clear();
     void add(hittable::ptr h_object);
+    void add(const hittable* h_object);  // non-owning: h_object must outlive the list (e.g. by living in arena)
     
-    virtual bool hit(const ray& r, double t_min, double t_max, hit_record& h) const override;
+    virtual bool hit(const ray& r, real t_min, real t_max, hit_record& h) const override;
+    
+    virtual bool occluded(const ray& r, real t_min, real t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
 
   public:
-    hittable::ptr_list h_list;
+    hittable::handle_list h_list;  // every object, in the order added
+    hittable::ptr_list owned;      // objects added as hittable::ptr
+    scene_arena::ptr arena;        // shared between copies of the list
 };
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "light_list.h"
+
+#include "../sphere/sphere.h"
+
+light_list::light_list() {}
+
+/* Collects every sphere in world whose material emits light */
+light_list::light_list(const hittable_list& world) {
+  for (const hittable* h_object : world.h_list) {
+    const sphere* s = dynamic_cast<const sphere*>(h_object);
+    if (!s || !s->material_ptr) continue;
+    color l = s->material_ptr->emitted();
+    if (l.x() > 0 || l.y() > 0 || l.z() > 0)
+      lights.push_back({s->center, std::fabs(s->radius), s->material_ptr});
+  }
+}
+
+size_t light_list::size() const {
+  return lights.size();
+}
+
+bool light_list::empty() const {
+  return lights.empty();
+}
+
+/* Density of uniform directions in the cone subtended by light at p; 0 from inside the light.
+   1 - cos(theta_max) is computed as sin^2/(1 + cos) so it doesn't cancel for small or distant lights. */
+double light_list::cone_pdf(const point3& p, const sphere_light& light) {
+  double d2 = (light.center - p).length_squared();
+  double r2 = light.radius * light.radius;
+  if (d2 <= r2) return 0.0;
+  double sin2_max = r2 / d2;
+  double cos_max = std::sqrt(1.0 - sin2_max);
+  return 1.0 / (2.0*pi * (sin2_max / (1.0 + cos_max)));
+}
+
+bool light_list::sample(const point3& p, light_sample& out) const {
+  if (lights.empty()) return false;
+  size_t pick = std::min(static_cast<size_t>(random_double() * lights.size()), lights.size() - 1);
+  const sphere_light& light = lights[pick];
+
+  vec3 to_center = light.center - p;
+  double d2 = to_center.length_squared();
+  double r2 = light.radius * light.radius;
+  if (d2 <= r2) return false;
+
+  // Uniform direction in the cone around w = to_center
+  double sin2_max = r2 / d2;
+  double one_minus_cos_max = sin2_max / (1.0 + std::sqrt(1.0 - sin2_max));
+  double xi_cos, xi_phi;
+  random_pair(xi_cos, xi_phi);
+  double one_minus_cos = xi_cos * one_minus_cos_max;
+  double cos_theta = 1.0 - one_minus_cos;
+  double sin_theta = std::sqrt(std::max(0.0, one_minus_cos * (2.0 - one_minus_cos)));
+  double phi = 2.0*pi * xi_phi;
+
+  vec3 w = to_center / std::sqrt(d2);
+  vec3 a = std::fabs(w.x()) > 0.9 ? y_hat() : x_hat();
+  vec3 u = unit_vector(cross(w, a));
+  vec3 v = cross(w, u);
+  out.direction = unit_vector(std::cos(phi)*sin_theta*u + std::sin(phi)*sin_theta*v + cos_theta*w);
+
+  // Distance to the near side of the sphere along the sampled direction
+  double b = dot(out.direction, to_center);
+  double disc = b*b - (d2 - r2);
+  out.distance = b - std::sqrt(std::max(disc, 0.0));
+  if (out.distance <= 0.0) return false;
+
+  out.pdf = 1.0 / (2.0*pi * one_minus_cos_max) / lights.size();
+  out.radiance = light.light_material->emitted();
+  return true;
+}
+
+/* Density sample() has of producing the direction from p toward on_light, a point on a light with light_material */
+double light_list::pdf(const point3& p, const point3& on_light, const material* light_material) const {
+  // Hit points are only as precise as 'real', so a float build needs a looser test for lying on a light's surface
+  const double tolerance = std::max(1e-6, 1e3 * std::numeric_limits<real>::epsilon());
+  for (const sphere_light& light : lights) {
+    if (light.light_material != light_material) continue;
+    double off_surface = std::fabs((on_light - light.center).length() - light.radius);
+    if (off_surface <= tolerance * std::max(light.radius, 1.0))
+      return cone_pdf(p, light) / lights.size();
+  }
+  return 0.0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../hittable_list/hittable_list.h"
+
+/* One light sample as seen from a shading point */
+struct light_sample {
+  vec3 direction;   // unit vector from the shading point toward the light
+  double distance;  // along direction to the light's surface
+  double pdf;       // solid angle density of picking direction, including the choice of light
+  color radiance;   // emitted toward the shading point
+};
+
+/* The emissive spheres of a scene, for next-event estimation. A light is picked uniformly, then a direction is drawn
+   uniformly from the cone the light's sphere subtends at the shading point. */
+class light_list {
+  public:
+    light_list();
+    light_list(const hittable_list& world);
+
+    bool sample(const point3& p, light_sample& out) const;  // false if p is inside the picked light or the sample failed
+    double pdf(const point3& p, const point3& on_light, const material* light_material) const;  // density sample() would give
+    size_t size() const;
+    bool empty() const;
+
+  private:
+    struct sphere_light {
+      point3 center;
+      double radius;
+      const material* light_material;
+    };
+
+    static double cone_pdf(const point3& p, const sphere_light& light);
+
+  public:
+    std::vector<sphere_light> lights;
+};
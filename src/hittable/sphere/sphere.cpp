@@ -2,21 +2,23 @@
 
 sphere::sphere() {}
 
-sphere::sphere(point3 c, double r, material::ptr m): center(c), radius(r), material_ptr(m) {}
+sphere::sphere(point3 c, real r, material::ptr m): center(c), radius(r), material_ptr(m.get()), material_owner(m) {}
 
-bool sphere::hit(const ray& r, double t_min, double t_max, hit_record& rec) const {
+sphere::sphere(point3 c, real r, const material* m): center(c), radius(r), material_ptr(m) {}
+
+bool sphere::hit(const ray& r, real t_min, real t_max, hit_record& rec) const {
   vec3 ray_direction = r.direction();
   vec3 origin_centre = r.origin() - center;
-  double a = ray_direction.length_squared();
-  double b = 2*dot(ray_direction, origin_centre);
-  double c = origin_centre.length_squared() - radius*radius;
+  real a = ray_direction.length_squared();
+  real b = 2*dot(ray_direction, origin_centre);
+  real c = origin_centre.length_squared() - radius*radius;
 
-  double discriminant = b*b - 4*a*c;
+  real discriminant = b*b - 4*a*c;
 
   if (discriminant < 0) return false;
 
   // check which root is within range
-  double t = (-b - std::sqrt(discriminant))/(2*a);
+  real t = (-b - std::sqrt(discriminant))/(2*a);
   if (t < t_min || t > t_max) {               // if first root is out of range, check second root
     t = (-b + std::sqrt(discriminant))/(2*a);
     if (t < t_min || t > t_max) return false;
@@ -28,5 +30,29 @@ bool sphere::hit(const ray& r, double t_min, double t_max, hit_record& rec) cons
   rec.set_face_normal(r, outward_normal);
   rec.material_ptr = material_ptr;
 
+  return true;
+}
+
+/* Shadow ray test: same roots as hit(), but nothing past the range check is computed */
+bool sphere::occluded(const ray& r, real t_min, real t_max) const {
+  vec3 ray_direction = r.direction();
+  vec3 origin_centre = r.origin() - center;
+  real a = ray_direction.length_squared();
+  real b = 2*dot(ray_direction, origin_centre);
+  real c = origin_centre.length_squared() - radius*radius;
+
+  real discriminant = b*b - 4*a*c;
+  if (discriminant < 0) return false;
+
+  real root = std::sqrt(discriminant);
+  real t = (-b - root)/(2*a);
+  if (t >= t_min && t <= t_max) return true;
+  t = (-b + root)/(2*a);
+  return t >= t_min && t <= t_max;
+}
+
+bool sphere::bounding_box(aabb& output_box) const {
+  vec3 extent(std::fabs(radius));
+  output_box = aabb(center - extent, center + extent);
   return true;
 }
\ No newline at end of file
@@ -6,12 +6,16 @@
 class sphere : public hittable {
   public:
     sphere();
-    sphere(point3 c, double r, material::ptr m);
+    sphere(point3 c, real r, material::ptr m);    // shares ownership of m
+    sphere(point3 c, real r, const material* m);  // non-owning: m must outlive the sphere (e.g. both in a scene_arena)
 
-    virtual bool hit(const ray& r, double t_min, double t_max, hit_record& rec) const override;
+    virtual bool hit(const ray& r, real t_min, real t_max, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, real t_min, real t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
 
   public:
     point3 center;
-    double radius;
-    material::ptr material_ptr;
+    real radius;
+    const material* material_ptr;
+    material::ptr material_owner;  // set only when constructed from a material::ptr
 };
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "sphere_soa.h"
+#include "../sphere/sphere.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+=======================================
+    SIMD lane wrapper
+=======================================
+  vd holds vd::width doubles. The kernel below is written once against it and compiled for whichever instruction set is
+  available. Comparisons return all-ones/all-zeros lane masks, and unordered (NaN-passing) predicates are used where
+  sphere::hit rejects with "<" / ">", so NaNs get through exactly as they do in the scalar code.
+*/
+
+#if defined(__AVX__)
+
+struct vd {
+  static const int width = 4;
+  __m256d v;
+};
+static inline vd load(const double* p)            { return { _mm256_load_pd(p) }; }
+static inline void store(double* p, vd a)         { _mm256_store_pd(p, a.v); }
+static inline vd set1(double d)                   { return { _mm256_set1_pd(d) }; }
+static inline vd operator+(vd a, vd b)            { return { _mm256_add_pd(a.v, b.v) }; }
+static inline vd operator-(vd a, vd b)            { return { _mm256_sub_pd(a.v, b.v) }; }
+static inline vd operator*(vd a, vd b)            { return { _mm256_mul_pd(a.v, b.v) }; }
+static inline vd operator/(vd a, vd b)            { return { _mm256_div_pd(a.v, b.v) }; }
+static inline vd operator&(vd a, vd b)            { return { _mm256_and_pd(a.v, b.v) }; }
+static inline vd operator|(vd a, vd b)            { return { _mm256_or_pd(a.v, b.v) }; }
+static inline vd negate(vd a)                     { return { _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)) }; }
+static inline vd sqrt(vd a)                       { return { _mm256_sqrt_pd(a.v) }; }
+static inline vd not_less(vd a, vd b)             { return { _mm256_cmp_pd(a.v, b.v, _CMP_NLT_UQ) }; }
+static inline vd not_greater(vd a, vd b)          { return { _mm256_cmp_pd(a.v, b.v, _CMP_NGT_UQ) }; }
+static inline vd select(vd mask, vd a, vd b)      { return { _mm256_blendv_pd(b.v, a.v, mask.v) }; }
+static inline bool any(vd mask)                   { return _mm256_movemask_pd(mask.v) != 0; }
+
+#elif defined(__SSE2__)
+
+struct vd {
+  static const int width = 2;
+  __m128d v;
+};
+static inline vd load(const double* p)            { return { _mm_load_pd(p) }; }
+static inline void store(double* p, vd a)         { _mm_store_pd(p, a.v); }
+static inline vd set1(double d)                   { return { _mm_set1_pd(d) }; }
+static inline vd operator+(vd a, vd b)            { return { _mm_add_pd(a.v, b.v) }; }
+static inline vd operator-(vd a, vd b)            { return { _mm_sub_pd(a.v, b.v) }; }
+static inline vd operator*(vd a, vd b)            { return { _mm_mul_pd(a.v, b.v) }; }
+static inline vd operator/(vd a, vd b)            { return { _mm_div_pd(a.v, b.v) }; }
+static inline vd operator&(vd a, vd b)            { return { _mm_and_pd(a.v, b.v) }; }
+static inline vd operator|(vd a, vd b)            { return { _mm_or_pd(a.v, b.v) }; }
+static inline vd negate(vd a)                     { return { _mm_xor_pd(a.v, _mm_set1_pd(-0.0)) }; }
+static inline vd sqrt(vd a)                       { return { _mm_sqrt_pd(a.v) }; }
+static inline vd not_less(vd a, vd b)             { return { _mm_cmpnlt_pd(a.v, b.v) }; }
+static inline vd not_greater(vd a, vd b)          { return { _mm_cmpngt_pd(a.v, b.v) }; }
+static inline vd select(vd mask, vd a, vd b)      { return { _mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v)) }; }
+static inline bool any(vd mask)                   { return _mm_movemask_pd(mask.v) != 0; }
+
+#else
+
+struct vd {  // scalar fallback; masks are 1.0 (true) / 0.0 (false)
+  static const int width = 1;
+  double v;
+};
+static inline vd load(const double* p)            { return { *p }; }
+static inline void store(double* p, vd a)         { *p = a.v; }
+static inline vd set1(double d)                   { return { d }; }
+static inline vd operator+(vd a, vd b)            { return { a.v + b.v }; }
+static inline vd operator-(vd a, vd b)            { return { a.v - b.v }; }
+static inline vd operator*(vd a, vd b)            { return { a.v * b.v }; }
+static inline vd operator/(vd a, vd b)            { return { a.v / b.v }; }
+static inline vd operator&(vd a, vd b)            { return { (a.v != 0.0 && b.v != 0.0) ? 1.0 : 0.0 }; }
+static inline vd operator|(vd a, vd b)            { return { (a.v != 0.0 || b.v != 0.0) ? 1.0 : 0.0 }; }
+static inline vd negate(vd a)                     { return { -a.v }; }
+static inline vd sqrt(vd a)                       { return { std::sqrt(a.v) }; }
+static inline vd not_less(vd a, vd b)             { return { !(a.v < b.v) ? 1.0 : 0.0 }; }
+static inline vd not_greater(vd a, vd b)          { return { !(a.v > b.v) ? 1.0 : 0.0 }; }
+static inline vd select(vd mask, vd a, vd b)      { return { mask.v != 0.0 ? a.v : b.v }; }
+static inline bool any(vd mask)                   { return mask.v != 0.0; }
+
+#endif
+
+/*
+=======================================
+    ray_packet
+=======================================
+*/
+
+void ray_packet::set(int lane, const ray& r) {
+  ox[lane] = r.orig.x(); oy[lane] = r.orig.y(); oz[lane] = r.orig.z();
+  dx[lane] = r.dir.x();  dy[lane] = r.dir.y();  dz[lane] = r.dir.z();
+}
+
+/*
+=======================================
+    sphere_soa
+=======================================
+*/
+
+sphere_soa::sphere_soa(): all_spheres(true) {}
+
+/* Copies every sphere out of the list, in list order */
+sphere_soa::sphere_soa(const hittable_list& list): all_spheres(true) {
+  for (const hittable* h_object : list.h_list) {
+    const sphere* s = dynamic_cast<const sphere*>(h_object);
+    if (s) add(s->center, s->radius, s->material_ptr);
+    else   all_spheres = false;
+  }
+}
+
+int sphere_soa::add_material(const material* m) {
+  auto found = material_lookup.find(m);
+  if (found != material_lookup.end()) return found->second;
+
+  int index = static_cast<int>(materials.size());
+  materials.push_back(m);
+  material_lookup[m] = index;
+  return index;
+}
+
+void sphere_soa::add(point3 c, double r, const material* m) {
+  add(c, r, add_material(m));
+}
+
+void sphere_soa::add(point3 c, double r, int m_index) {
+  cx.push_back(c.x());
+  cy.push_back(c.y());
+  cz.push_back(c.z());
+  radius.push_back(r);
+  material_index.push_back(m_index);
+}
+
+size_t sphere_soa::size() const {
+  return radius.size();
+}
+
+bool sphere_soa::empty() const {
+  return radius.empty();
+}
+
+bool sphere_soa::complete() const {
+  return all_spheres;
+}
+
+/* Same arithmetic as sphere::hit, keeping the closest root across all spheres like hittable_list::hit does */
+bool sphere_soa::hit(const ray& r, real t_min, real t_max, hit_record& rec) const {
+  const double ox = r.orig.x(), oy = r.orig.y(), oz = r.orig.z();
+  const double dx = r.dir.x(),  dy = r.dir.y(),  dz = r.dir.z();
+  const double a = dx*dx + dy*dy + dz*dz;
+  const size_t count = radius.size();
+
+  double t_closest = t_max;
+  long best = -1;
+  for (size_t s = 0; s < count; ++s) {
+    double ocx = ox - cx[s];
+    double ocy = oy - cy[s];
+    double ocz = oz - cz[s];
+
+    double b = 2*(dx*ocx + dy*ocy + dz*ocz);
+    double c = (ocx*ocx + ocy*ocy + ocz*ocz) - radius[s]*radius[s];
+    double discriminant = b*b - 4*a*c;
+    if (discriminant < 0) continue;
+
+    double root = std::sqrt(discriminant);
+    double t = (-b - root)/(2*a);
+    if (t < t_min || t > t_closest) {
+      t = (-b + root)/(2*a);
+      if (t < t_min || t > t_closest) continue;
+    }
+    t_closest = t;
+    best = static_cast<long>(s);
+  }
+
+  if (best < 0) return false;
+  finalize_hit(r, static_cast<int>(best), t_closest, rec);
+  return true;
+}
+
+/* Same arithmetic as hit(), returning at the first sphere with a root in range */
+bool sphere_soa::occluded(const ray& r, real t_min, real t_max) const {
+  const double ox = r.orig.x(), oy = r.orig.y(), oz = r.orig.z();
+  const double dx = r.dir.x(),  dy = r.dir.y(),  dz = r.dir.z();
+  const double a = dx*dx + dy*dy + dz*dz;
+  const size_t count = radius.size();
+
+  for (size_t s = 0; s < count; ++s) {
+    double ocx = ox - cx[s];
+    double ocy = oy - cy[s];
+    double ocz = oz - cz[s];
+
+    double b = 2*(dx*ocx + dy*ocy + dz*ocz);
+    double c = (ocx*ocx + ocy*ocy + ocz*ocz) - radius[s]*radius[s];
+    double discriminant = b*b - 4*a*c;
+    if (discriminant < 0) continue;
+
+    double root = std::sqrt(discriminant);
+    double t1 = (-b - root)/(2*a);
+    double t2 = (-b + root)/(2*a);
+    if ((t1 >= t_min && t1 <= t_max) || (t2 >= t_min && t2 <= t_max)) return true;
+  }
+  return false;
+}
+
+bool sphere_soa::bounding_box(aabb& output_box) const {
+  if (empty()) return false;
+
+  output_box = aabb();
+  for (size_t s = 0; s < radius.size(); ++s) {
+    vec3 extent(std::fabs(radius[s]));
+    point3 center(cx[s], cy[s], cz[s]);
+    output_box = surrounding_box(output_box, aabb(center - extent, center + extent));
+  }
+  return true;
+}
+
+/* Same arithmetic as sphere::hit, one lane per ray. Each lane keeps its own closest t, which shrinks as spheres are hit,
+   exactly like t_closest in hittable_list::hit. */
+void sphere_soa::hit_packet(const ray_packet& rp, double t_min, double t_max, packet_hit& ph) const {
+  alignas(32) double best_index[ray_packet::size];
+  const size_t count = radius.size();
+
+  for (int g = 0; g < ray_packet::size; g += vd::width) {
+    vd ox = load(rp.ox + g), oy = load(rp.oy + g), oz = load(rp.oz + g);
+    vd dx = load(rp.dx + g), dy = load(rp.dy + g), dz = load(rp.dz + g);
+
+    vd a      = dx*dx + dy*dy + dz*dz;
+    vd four_a = set1(4.0)*a;
+    vd two_a  = set1(2.0)*a;
+    vd lo     = set1(t_min);
+
+    vd t_closest = set1(t_max);
+    vd index     = set1(-1.0);
+
+    for (size_t s = 0; s < count; ++s) {
+      vd ocx = ox - set1(cx[s]);
+      vd ocy = oy - set1(cy[s]);
+      vd ocz = oz - set1(cz[s]);
+
+      vd b = set1(2.0)*(dx*ocx + dy*ocy + dz*ocz);
+      vd c = (ocx*ocx + ocy*ocy + ocz*ocz) - set1(radius[s]*radius[s]);
+      vd discriminant = b*b - four_a*c;
+
+      vd has_roots = not_less(discriminant, set1(0.0));
+      if (!any(has_roots)) continue;
+
+      vd root = sqrt(discriminant);
+      vd neg_b = negate(b);
+      vd t1 = (neg_b - root)/two_a;
+      vd t2 = (neg_b + root)/two_a;
+      vd t1_ok = not_less(t1, lo) & not_greater(t1, t_closest);
+      vd t2_ok = not_less(t2, lo) & not_greater(t2, t_closest);
+
+      vd hit = has_roots & (t1_ok | t2_ok);
+      t_closest = select(hit, select(t1_ok, t1, t2), t_closest);
+      index     = select(hit, set1(double(s)), index);
+    }
+
+    store(ph.t + g, t_closest);
+    store(best_index + g, index);
+  }
+
+  for (int lane = 0; lane < ray_packet::size; ++lane)
+    ph.index[lane] = static_cast<int>(best_index[lane]);
+}
+
+/* Fills the hit record for a ray that hit sphere 'index' at 't', the same way sphere::hit does */
+void sphere_soa::finalize_hit(const ray& r, int index, real t, hit_record& rec) const {
+  point3 center(cx[index], cy[index], cz[index]);
+  rec.t = t;
+  rec.p = r.at(rec.t);
+  vec3 outward_normal = (rec.p - center)/radius[index];
+  rec.set_face_normal(r, outward_normal);
+  rec.material_ptr = materials[material_index[index]];
+}
+
+const char* sphere_soa::simd_path() {
+#if defined(__AVX__)
+  return "AVX";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../hittable.h"
+#include "../hittable_list/hittable_list.h"
+
+#include <unordered_map>
+
+/* Bundle of rays traced together, stored as structure-of-arrays so each component loads straight into a SIMD register.
+   4 rays = one AVX register of doubles per component. */
+struct ray_packet {
+  static constexpr int size = 4;
+
+  alignas(32) double ox[size], oy[size], oz[size];
+  alignas(32) double dx[size], dy[size], dz[size];
+
+  void set(int lane, const ray& r);
+};
+
+/* Closest hit for each ray in a packet. index is -1 where the ray hit nothing. */
+struct packet_hit {
+  alignas(32) double t[ray_packet::size];
+  int index[ray_packet::size];
+};
+
+/* Set of spheres stored as structure-of-arrays: centers, radii and material indices each live in their own contiguous array,
+   and each distinct material is stored once in a table. hit() is a tight non-virtual loop over those arrays, with no
+   per-sphere pointer chasing or refcounting. hit_packet() intersects a whole ray packet against every sphere, using AVX or
+   SSE2 when the compiler targets them and a plain scalar loop otherwise. Both paths do the same floating point operations
+   in the same order as sphere::hit, so their hit records are bit-identical to tracing a hittable_list of the same spheres.
+   The arrays are always double: in a float (RT_USE_FLOAT) build the results agree with sphere::hit only to float precision. */
+class sphere_soa : public hittable {
+  public:
+    sphere_soa();
+    sphere_soa(const hittable_list& list);
+
+    int  add_material(const material* m);  // returns the material's index, adding it to the table if it's not there yet
+    void add(point3 c, double r, const material* m);
+    void add(point3 c, double r, int material_index);
+    size_t size() const;
+    bool empty() const;
+    bool complete() const;  // false if the list it was built from contained objects other than spheres
+
+    virtual bool hit(const ray& r, real t_min, real t_max, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, real t_min, real t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+
+    void hit_packet(const ray_packet& rp, double t_min, double t_max, packet_hit& ph) const;
+    void finalize_hit(const ray& r, int index, real t, hit_record& rec) const;
+
+    static const char* simd_path();
+
+  public:
+    std::vector<double> cx, cy, cz;
+    std::vector<double> radius;
+    std::vector<int> material_index;
+    std::vector<const material*> materials;  // material table, indexed by material_index; owned by the scene
+
+  private:
+    std::unordered_map<const material*, int> material_lookup;
+    bool all_spheres;
+};
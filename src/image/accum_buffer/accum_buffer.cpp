@@ -0,0 +1,83 @@
+#include "accum_buffer.h"
+
+#include <algorithm>
+
+accum_buffer::accum_buffer(int w, int h): r(w*h, 0.0f), g(w*h, 0.0f), b(w*h, 0.0f), count(w*h, 0), width(w), height(h) {}
+
+void accum_buffer::add(int x, int y, const color& sum, int n) {
+  int i = y*width + x;
+  r[i] += static_cast<float>(sum.R());
+  g[i] += static_cast<float>(sum.G());
+  b[i] += static_cast<float>(sum.B());
+  count[i] += n;
+}
+
+void accum_buffer::clear() {
+  std::fill(r.begin(), r.end(), 0.0f);
+  std::fill(g.begin(), g.end(), 0.0f);
+  std::fill(b.begin(), b.end(), 0.0f);
+  std::fill(count.begin(), count.end(), 0);
+}
+
+void accum_buffer::clear(int x0, int y0, int x1, int y1) {
+  for (int y = y0; y < y1; ++y) {
+    int row = y*width;
+    std::fill(r.begin() + row + x0, r.begin() + row + x1, 0.0f);
+    std::fill(g.begin() + row + x0, g.begin() + row + x1, 0.0f);
+    std::fill(b.begin() + row + x0, b.begin() + row + x1, 0.0f);
+    std::fill(count.begin() + row + x0, count.begin() + row + x1, 0);
+  }
+}
+
+color accum_buffer::mean(int i) const {
+  if (count[i] == 0) return color(0,0,0);
+  double inv = 1.0 / count[i];
+  return color(r[i]*inv, g[i]*inv, b[i]*inv);
+}
+
+int accum_buffer::samples(int i) const {
+  return static_cast<int>(count[i]);
+}
+
+void accum_buffer::resolve(Uint32* pixels, double exposure, tone_mapping tm) const {
+  resolve(pixels, 0, 0, width, height, exposure, tm);
+}
+
+/* Kept free of data-dependent branches (pixels with no samples come out black via the max(count, 1) divide) so the inner
+   loop vectorizes; the tone mapping choice is a template parameter for the same reason. */
+template <bool REINHARD>
+static void resolve_rows(const accum_buffer& acc, Uint32* pixels, int x0, int y0, int x1, int y1, float exposure) {
+  const float* __restrict R = acc.r.data();
+  const float* __restrict G = acc.g.data();
+  const float* __restrict B = acc.b.data();
+  const uint32_t* __restrict N = acc.count.data();
+
+  for (int y = y0; y < y1; ++y) {
+    const int row = y*acc.width;
+    for (int x = x0; x < x1; ++x) {
+      const int i = row + x;
+      const float scale = exposure / static_cast<float>(std::max(static_cast<int>(N[i]), 1));
+      float cr = R[i]*scale, cg = G[i]*scale, cb = B[i]*scale;
+      if (REINHARD) {
+        cr = cr/(1.0f + cr);
+        cg = cg/(1.0f + cg);
+        cb = cb/(1.0f + cb);
+      }
+      // gamma 2 (sqrt), clamped to the displayable range, then quantized like convert_to_ARGB8888
+      cr = std::sqrt(std::min(std::max(cr, 0.0f), 1.0f));
+      cg = std::sqrt(std::min(std::max(cg, 0.0f), 1.0f));
+      cb = std::sqrt(std::min(std::max(cb, 0.0f), 1.0f));
+      pixels[i] = 0xFF000000u |
+        (static_cast<Uint32>(static_cast<int>(255.999f*cr)) << 16) |  // via int: signed conversions vectorize, unsigned don't
+        (static_cast<Uint32>(static_cast<int>(255.999f*cg)) << 8)  |
+        (static_cast<Uint32>(static_cast<int>(255.999f*cb)));
+    }
+  }
+}
+
+void accum_buffer::resolve(Uint32* pixels, int x0, int y0, int x1, int y1, double exposure, tone_mapping tm) const {
+  if (tm == tone_mapping::REINHARD)
+    resolve_rows<true>(*this, pixels, x0, y0, x1, y1, static_cast<float>(exposure));
+  else
+    resolve_rows<false>(*this, pixels, x0, y0, x1, y1, static_cast<float>(exposure));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+enum class tone_mapping { NONE, REINHARD };
+
+/* Linear radiance accumulation buffer: per-pixel running sums of sample colors (one float plane per channel) and the
+   number of samples behind each sum. Renders add to it and never overwrite it, so any number of passes can be added
+   before resolving. Accumulation takes no locks or atomics: within a pass every tile belongs to exactly one worker, and
+   passes are separated by the worker pool's completion, so no two threads ever touch the same pixel at the same time.
+
+   resolve() turns the sums into displayable ARGB8888 pixels (average, exposure, tone map, gamma, quantize). It is a
+   branch-free loop over the planes that the compiler vectorizes. */
+class accum_buffer {
+  public:
+    accum_buffer(int w, int h);
+
+    void   add(int x, int y, const color& sum, int n);
+    void   clear();
+    void   clear(int x0, int y0, int x1, int y1);  // one region
+    color  mean(int index) const;
+    int    samples(int index) const;
+
+    void resolve(Uint32* pixels, double exposure, tone_mapping tm) const;                              // whole frame
+    void resolve(Uint32* pixels, int x0, int y0, int x1, int y1, double exposure, tone_mapping tm) const;  // one region
+
+  public:
+    std::vector<float> r, g, b;
+    std::vector<uint32_t> count;
+    int width;
+    int height;
+};
@@ -0,0 +1,68 @@
+#include "aov_buffer.h"
+
+#include <algorithm>
+
+aov_sample& aov_sample::operator+=(const aov_sample& s) {
+  albedo += s.albedo;
+  normal += s.normal;
+  depth += s.depth;
+  lum += s.lum;
+  lum2 += s.lum2;
+  return *this;
+}
+
+aov_buffer::aov_buffer(int w, int h): width(w), height(h) {}
+
+void aov_buffer::allocate() {
+  if (allocated()) return;
+  for (std::vector<float>* plane : planes()) plane->assign(width*height, 0.0f);
+  count.assign(width*height, 0);
+}
+
+bool aov_buffer::allocated() const {
+  return !count.empty();
+}
+
+void aov_buffer::add(int x, int y, const aov_sample& sum, int n) {
+  int i = y*width + x;
+  albedo_r[i] += static_cast<float>(sum.albedo.R());
+  albedo_g[i] += static_cast<float>(sum.albedo.G());
+  albedo_b[i] += static_cast<float>(sum.albedo.B());
+  normal_x[i] += static_cast<float>(sum.normal.x());
+  normal_y[i] += static_cast<float>(sum.normal.y());
+  normal_z[i] += static_cast<float>(sum.normal.z());
+  depth[i] += static_cast<float>(sum.depth);
+  lum[i] += static_cast<float>(sum.lum);
+  lum2[i] += static_cast<float>(sum.lum2);
+  count[i] += n;
+}
+
+void aov_buffer::clear() {
+  clear(0, 0, width, height);
+}
+
+void aov_buffer::clear(int x0, int y0, int x1, int y1) {
+  if (!allocated()) return;
+  for (int y = y0; y < y1; ++y) {
+    int row = y*width;
+    for (std::vector<float>* plane : planes())
+      std::fill(plane->begin() + row + x0, plane->begin() + row + x1, 0.0f);
+    std::fill(count.begin() + row + x0, count.begin() + row + x1, 0);
+  }
+}
+
+std::vector<std::vector<float>*> aov_buffer::planes() {
+  return {&albedo_r, &albedo_g, &albedo_b, &normal_x, &normal_y, &normal_z, &depth, &lum, &lum2};
+}
+
+aov_sample aov_buffer::mean(int i) const {
+  aov_sample m;
+  if (count[i] == 0) return m;
+  double inv = 1.0 / count[i];
+  m.albedo = color(albedo_r[i]*inv, albedo_g[i]*inv, albedo_b[i]*inv);
+  m.normal = vec3(normal_x[i]*inv, normal_y[i]*inv, normal_z[i]*inv);
+  m.depth = depth[i]*inv;
+  m.lum = lum[i]*inv;
+  m.lum2 = lum2[i]*inv;
+  return m;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+/* Features of one sample, or their sum over several. The denoiser uses them to tell edges from noise. Mirror and glass
+   hits are looked through: albedo and normal are those of the first diffuse surface the sample's path meets. */
+struct aov_sample {
+  color  albedo;  // albedo of that surface times the albedos on the way there; misses and emitters count as white
+  vec3   normal;  // normal of that surface; 0 for misses
+  double depth;   // distance to the first hit; 0 for misses
+  double lum;     // luminance of the sample's radiance divided by the luminance of its albedo
+  double lum2;    // square of lum (summed, it gives the pixel's variance)
+
+  aov_sample(): depth(0), lum(0), lum2(0) {}
+  aov_sample& operator+=(const aov_sample& s);
+};
+
+/* Feature buffers ("arbitrary output variables") that sit alongside accum_buffer. They hold running sums of the
+   albedo, normal and depth, and the first two moments of the demodulated luminance, over the same samples as the
+   image's radiance sums. The planes are only allocated when something will use them (allocate()): renders record
+   features into images whose aov_buffer is allocated, and skip them otherwise. Like accum_buffer, they are added to without locks, because a pixel is only ever touched by
+   the worker that owns its tile. */
+class aov_buffer {
+  public:
+    aov_buffer(int w, int h);  // unallocated
+
+    void       allocate();         // zeroed planes; no effect once allocated
+    bool       allocated() const;
+
+    void       add(int x, int y, const aov_sample& sum, int n);
+    void       clear();
+    void       clear(int x0, int y0, int x1, int y1);  // one region
+    aov_sample mean(int index) const;
+    std::vector<std::vector<float>*> planes();  // every float plane, for code that treats them alike
+
+  public:
+    std::vector<float> albedo_r, albedo_g, albedo_b;
+    std::vector<float> normal_x, normal_y, normal_z;
+    std::vector<float> depth, lum, lum2;
+    std::vector<uint32_t> count;
+    int width;
+    int height;
+};
@@ -1,6 +1,6 @@
 #include "image.h"
 
-image::image(int w, int h): width(w), height(h) {
+image::image(int w, int h): accum(w, h), aov(w, h), width(w), height(h) {
   pixels = new Uint32[w*h];
   for (int i = 0; i < w*h; ++i)
     pixels[i] = 0x00000000;
@@ -10,6 +10,16 @@ image::~image() {
   delete[] pixels;
 }
 
+void image::clear() {
+  accum.clear();
+  aov.clear();
+}
+
+void image::clear(int x0, int y0, int x1, int y1) {
+  accum.clear(x0, y0, x1, y1);
+  aov.clear(x0, y0, x1, y1);
+}
+
 Uint32& image::operator [] (int index) {
   return pixels[index];
 }
@@ -24,4 +34,16 @@ Uint32& image::operator () (int x, int y) {
 
 Uint32 image::operator () (int x, int y) const {
   return pixels[y*width + x];
-}
\ No newline at end of file
+}
+
+std::vector<std::vector<float>*> image::float_planes() {
+  std::vector<std::vector<float>*> planes = {&accum.r, &accum.g, &accum.b};
+  if (aov.allocated())
+    for (std::vector<float>* p : aov.planes()) planes.push_back(p);
+  return planes;
+}
+
+std::vector<std::vector<uint32_t>*> image::count_planes() {
+  if (!aov.allocated()) return {&accum.count};
+  return {&accum.count, &aov.count};
+}
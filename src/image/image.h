@@ -1,18 +1,28 @@
 #pragma once
 
+#include "accum_buffer/accum_buffer.h"
+#include "aov_buffer/aov_buffer.h"
+
 class image {
   public:
     image(int w, int h);
 
     ~image();
 
+    void clear();  // empties accum & aov, so the next render starts from no samples
+    void clear(int x0, int y0, int x1, int y1);  // the same for one region
+    std::vector<std::vector<float>*> float_planes();     // accum's r, g, b then aov's planes if allocated, the order farm tiles & checkpoints use
+    std::vector<std::vector<uint32_t>*> count_planes();  // accum's then (if allocated) aov's sample counts
+
     Uint32& operator [] (int index);
     Uint32  operator [] (int index)     const;
     Uint32& operator () (int x, int y);
     Uint32  operator () (int x, int y)  const;
         
   public:
-    Uint32* pixels;
+    Uint32* pixels;      // displayable ARGB8888, resolved from accum
+    accum_buffer accum;  // linear radiance sums & sample counts
+    aov_buffer aov;      // first-hit feature sums over the same samples, for the denoiser
     int width;
     int height;
 };
\ No newline at end of file
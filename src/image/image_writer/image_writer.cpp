@@ -0,0 +1,248 @@
+#include "image_writer.h"
+
+#include <cstring>
+
+/*
+=======================================
+    Encoders
+=======================================
+*/
+
+static void append(std::vector<unsigned char>& out, const std::string& s) {
+  out.insert(out.end(), s.begin(), s.end());
+}
+
+static void append_be32(std::vector<unsigned char>& out, uint32_t v) {
+  out.push_back(v >> 24); out.push_back(v >> 16); out.push_back(v >> 8); out.push_back(v);
+}
+
+static std::vector<unsigned char> encode_PPM(const image& img) {
+  std::vector<unsigned char> out;
+  append(out, "P6\n" + std::to_string(img.width) + ' ' + std::to_string(img.height) + "\n255\n");
+  size_t header = out.size();
+  out.resize(header + 3*size_t(img.width)*img.height);
+
+  unsigned char* p = out.data() + header;
+  for (int i = 0; i < img.width*img.height; ++i) {
+    Uint32 argb = img[i];
+    *p++ = (argb >> 16) & 0xFF;
+    *p++ = (argb >> 8)  & 0xFF;
+    *p++ =  argb        & 0xFF;
+  }
+  return out;
+}
+
+/* PFM stores scanlines bottom to top; a negative scale in the header means little-endian floats */
+static std::vector<unsigned char> encode_PFM(const image& img) {
+  uint32_t probe = 1;
+  bool little_endian = *reinterpret_cast<unsigned char*>(&probe) == 1;
+
+  std::vector<unsigned char> out;
+  append(out, "PF\n" + std::to_string(img.width) + ' ' + std::to_string(img.height) + (little_endian ? "\n-1.0\n" : "\n1.0\n"));
+  size_t header = out.size();
+  size_t row_bytes = 3*sizeof(float)*size_t(img.width);
+  out.resize(header + row_bytes*img.height);
+
+  std::vector<float> row(3*size_t(img.width));
+  for (int y = 0; y < img.height; ++y) {
+    for (int x = 0; x < img.width; ++x) {
+      color c = img.accum.mean(y*img.width + x);
+      row[3*x] = c.R(); row[3*x+1] = c.G(); row[3*x+2] = c.B();
+    }
+    std::memcpy(out.data() + header + row_bytes*(img.height - 1 - y), row.data(), row_bytes);
+  }
+  return out;
+}
+
+static uint32_t crc32(const unsigned char* data, size_t len, uint32_t crc = 0) {
+  static uint32_t table[256];
+  static bool table_ready = [] {
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+    return true;
+  }();
+  (void)table_ready;
+
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static uint32_t adler32(const unsigned char* data, size_t len) {
+  const uint32_t mod = 65521;
+  uint32_t a = 1, b = 0;
+  while (len > 0) {
+    size_t block = len < 5552 ? len : 5552;  // largest run that can't overflow b before the modulo
+    len -= block;
+    while (block--) {
+      a += *data++;
+      b += a;
+    }
+    a %= mod;
+    b %= mod;
+  }
+  return (b << 16) | a;
+}
+
+static void append_png_chunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+  append_be32(out, static_cast<uint32_t>(data.size()));
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  append_be32(out, crc32(out.data() + start, out.size() - start));
+}
+
+static std::vector<unsigned char> encode_PNG(const image& img) {
+  // Raw scanlines, each prefixed with filter type 0 (none)
+  size_t row_bytes = 1 + 3*size_t(img.width);
+  std::vector<unsigned char> raw(row_bytes*img.height);
+  for (int y = 0; y < img.height; ++y) {
+    unsigned char* p = raw.data() + row_bytes*y;
+    *p++ = 0;
+    for (int x = 0; x < img.width; ++x) {
+      Uint32 argb = img(x, y);
+      *p++ = (argb >> 16) & 0xFF;
+      *p++ = (argb >> 8)  & 0xFF;
+      *p++ =  argb        & 0xFF;
+    }
+  }
+
+  // zlib stream of stored deflate blocks (at most 65535 bytes each)
+  std::vector<unsigned char> zlib = {0x78, 0x01};
+  size_t offset = 0;
+  do {
+    size_t block = std::min<size_t>(65535, raw.size() - offset);
+    bool last = offset + block == raw.size();
+    zlib.push_back(last ? 1 : 0);
+    zlib.push_back(block & 0xFF);
+    zlib.push_back(block >> 8);
+    zlib.push_back(~block & 0xFF);
+    zlib.push_back((~block >> 8) & 0xFF);
+    zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + block);
+    offset += block;
+  } while (offset < raw.size());
+  append_be32(zlib, adler32(raw.data(), raw.size()));
+
+  std::vector<unsigned char> ihdr;
+  append_be32(ihdr, img.width);
+  append_be32(ihdr, img.height);
+  ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});  // 8-bit depth, RGB, deflate, adaptive filtering, no interlace
+
+  std::vector<unsigned char> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  append_png_chunk(out, "IHDR", ihdr);
+  append_png_chunk(out, "IDAT", zlib);
+  append_png_chunk(out, "IEND", {});
+  return out;
+}
+
+/*
+=======================================
+    File output
+=======================================
+*/
+
+image_format format_from_filename(const std::string& filename) {
+  std::string ext = filename.substr(filename.find_last_of('.') + 1);
+  for (char& c : ext) c = std::tolower(c);
+  if (ext == "pfm") return image_format::PFM;
+  if (ext == "png") return image_format::PNG;
+  return image_format::PPM;
+}
+
+std::string filename_with_suffix(const std::string& filename, const std::string& suffix) {
+  size_t dot = filename.rfind('.');
+  size_t slash = filename.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return filename + suffix;
+  return filename.substr(0, dot) + suffix + filename.substr(dot);
+}
+
+bool write_image(const std::string& filename, const image& img) {
+  return write_image(filename, img, format_from_filename(filename));
+}
+
+bool write_image(const std::string& filename, const image& img, image_format format) {
+  std::vector<unsigned char> data;
+  switch (format) {
+    case image_format::PPM: data = encode_PPM(img); break;
+    case image_format::PFM: data = encode_PFM(img); break;
+    case image_format::PNG: data = encode_PNG(img); break;
+  }
+
+  std::ofstream out(filename, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(data.data()), data.size());
+  if (!out) {
+    std::cerr << "Could not write image '" << filename << "'." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/*
+=======================================
+    async_image_writer
+=======================================
+*/
+
+async_image_writer::async_image_writer(): pending(0), stopping(false) {
+  worker = std::thread(&async_image_writer::run, this);
+}
+
+async_image_writer::~async_image_writer() {
+  {
+    std::lock_guard<std::mutex> lock(m);
+    stopping = true;
+  }
+  job_added.notify_one();
+  worker.join();  // run() drains the queue before returning
+}
+
+void async_image_writer::submit(const std::string& filename, image* img) {
+  {
+    std::lock_guard<std::mutex> lock(m);
+    jobs.push_back(job{filename, img, std::unique_ptr<image>(img)});
+    ++pending;
+  }
+  job_added.notify_one();
+}
+
+void async_image_writer::submit_borrowed(const std::string& filename, const image& img) {
+  {
+    std::lock_guard<std::mutex> lock(m);
+    jobs.push_back(job{filename, &img, nullptr});
+    ++pending;
+  }
+  job_added.notify_one();
+}
+
+void async_image_writer::wait() {
+  std::unique_lock<std::mutex> lock(m);
+  job_finished.wait(lock, [this] { return pending == 0; });
+}
+
+void async_image_writer::run() {
+  while (true) {
+    job j;
+    {
+      std::unique_lock<std::mutex> lock(m);
+      job_added.wait(lock, [this] { return stopping || !jobs.empty(); });
+      if (jobs.empty()) return;  // stopping, and nothing left to write
+      j = std::move(jobs.front());
+      jobs.pop_front();
+    }
+
+    write_image(j.filename, *j.img);
+    j.owned.reset();
+
+    {
+      std::lock_guard<std::mutex> lock(m);
+      --pending;
+    }
+    job_finished.notify_all();
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#include "../image.h"
+
+/*
+  Image file output. Each format is assembled into one memory buffer and written with a single call:
+    PPM - binary P6, 8 bits per channel (gamma corrected)
+    PFM - portable float map, linear radiance as 32-bit floats, averaged from image::accum before gamma & quantization
+    PNG - 8-bit RGB, zlib stream made of uncompressed ("stored") deflate blocks so no compression library is needed
+*/
+enum class image_format { PPM, PFM, PNG };
+
+image_format format_from_filename(const std::string& filename);  // by extension; defaults to PPM
+std::string filename_with_suffix(const std::string& filename, const std::string& suffix);  // "name<suffix>.ext", or "name<suffix>" without an extension
+
+bool write_image(const std::string& filename, const image& img);
+bool write_image(const std::string& filename, const image& img, image_format format);
+
+/* Writes images on a background thread, so encoding & disk I/O for one frame overlap with rendering the next.
+   submit() takes ownership of the image; with submit_borrowed() the caller must leave the image alone until wait() returns.
+   wait() (and the destructor) block until every submitted image is on disk. */
+class async_image_writer {
+  public:
+    async_image_writer();
+    ~async_image_writer();
+
+    void submit(const std::string& filename, image* img);
+    void submit_borrowed(const std::string& filename, const image& img);
+    void wait();
+
+  private:
+    void run();
+
+    struct job {
+      std::string filename;
+      const image* img;
+      std::unique_ptr<image> owned;  // null for borrowed images
+    };
+
+  private:
+    std::deque<job> jobs;
+    std::mutex m;
+    std::condition_variable job_added;
+    std::condition_variable job_finished;
+    int pending;
+    bool stopping;
+    std::thread worker;
+};
@@ -1,51 +1,166 @@
 #include "renderer/renderer.h"
-#include "material/matte/matte.h"
-#include "material/metal/metal.h"
-#include "hittable/sphere/sphere.h"
+#include "renderer/render_farm/render_farm.h"
+#include "scene/scene_file.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
 
 using namespace std;
 
-int main() {
+/* Scene rendered when no scene file is given (the l = cos(pi/4) four sphere scene) */
+static const char demo_scene[] = R"(
+width  1280
+spp    10
+depth  50
+
+#      lookfrom     lookat    focusat                 vup     vfov  aperture
+camera 1 0 0.1      0 0 -1    0.70710725 0.0 -1.0     0 1 0   70    0.05
+
+material ground matte 0.8 0.8 0.0
+material center matte 0.4 0.4 0.4
+material left   metal 0.8 0.8 0.8  0.1
+material right  metal 0.8 0.6 0.2  0.2
+
+sphere  0.0        -71.06427865  -1.0  70.71072503  ground
+sphere  0.0          0.0         -1.0   0.31819826  center
+sphere -0.70710725   0.0         -1.0   0.35355363  left
+sphere  0.70710725   0.0         -1.0   0.35355363  right
+)";
+
+static void print_usage() {
+    cout << "Usage: rt-weekend [scene file] [options]" << endl
+         << "  -o, --output <target>   'window' (default) or an image file: .ppm, .png or .pfm" << endl
+         << "  --width <pixels>        image width (height follows the scene's aspect ratio unless --height is given)" << endl
+         << "  --height <pixels>" << endl
+         << "  --spp <samples>         samples per pixel" << endl
+         << "  --depth <bounces>       bounce depth" << endl
+         << "  --threads <count>       worker threads (default: all hardware threads)" << endl
+         << "  --wavefront             trace breadth-first in material-sorted batches" << endl
+         << "  --sampler <pattern>     'sobol' (default): stratified, per-pixel scrambled sample sequences; 'random'" << endl
+         << "  --denoise               filter the finished image, guided by first-hit albedo, normal & depth" << endl
+         << "  --aovs                  with a file output, also write <name>_albedo/_normal/_depth images" << endl
+         << "  --orbit <seconds>       render video frames (output/<N>.ppm, 30 fps) of the camera circling the look-at point" << endl
+         << "  --checkpoint <file>     keep the render's progress in file (every 60 s, or see --checkpoint-interval)" << endl
+         << "  --checkpoint-interval <seconds>" << endl
+         << "                          how often the checkpoint file is brought up to date (default 60)" << endl
+         << "  --resume                continue the render kept in the --checkpoint file; needs the same scene & options" << endl
+         << "  --listen <address>      coordinate a render farm: hand tiles to workers connecting at [host]:port or unix:<path>" << endl
+         << "  --worker <address>      render tiles for the coordinator at address (takes no scene or render options)" << endl
+         << "  --save-binary <file>    write the scene in the binary scene format and exit" << endl
+         << "Scene file format: see src/scene/scene_file.h. Without a scene file, a built-in demo scene is rendered." << endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    /* Command line */
+    string scene_file, output = "window", binary_file, listen_address, worker_address, checkpoint_file;
+    int width = 0, height = 0, spp = 0, depth = 0, orbit_seconds = 0;
+    int threads = thread::hardware_concurrency();
+    bool wavefront = false, denoise = false, aovs = false, resume = false;
+    double checkpoint_interval = 60;
+    sample_pattern sampling = sample_pattern::SOBOL;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--help") {
+            print_usage();
+            return 0;
+        }
+        else if ((arg == "-o" || arg == "--output") && has_value) output = argv[++i];
+        else if (arg == "--width" && has_value)       width = atoi(argv[++i]);
+        else if (arg == "--height" && has_value)      height = atoi(argv[++i]);
+        else if (arg == "--spp" && has_value)         spp = atoi(argv[++i]);
+        else if (arg == "--depth" && has_value)       depth = atoi(argv[++i]);
+        else if (arg == "--threads" && has_value)     threads = atoi(argv[++i]);
+        else if (arg == "--wavefront")                wavefront = true;
+        else if (arg == "--denoise")                  denoise = true;
+        else if (arg == "--aovs")                     aovs = true;
+        else if (arg == "--sampler" && has_value && (string(argv[i+1]) == "sobol" || string(argv[i+1]) == "random"))
+            sampling = string(argv[++i]) == "sobol" ? sample_pattern::SOBOL : sample_pattern::RANDOM;
+        else if (arg == "--orbit" && has_value)       orbit_seconds = atoi(argv[++i]);
+        else if (arg == "--checkpoint" && has_value)  checkpoint_file = argv[++i];
+        else if (arg == "--checkpoint-interval" && has_value) checkpoint_interval = atof(argv[++i]);
+        else if (arg == "--resume")                   resume = true;
+        else if (arg == "--listen" && has_value)      listen_address = argv[++i];
+        else if (arg == "--worker" && has_value)      worker_address = argv[++i];
+        else if (arg == "--save-binary" && has_value) binary_file = argv[++i];
+        else if (arg[0] != '-' && scene_file.empty()) scene_file = arg;
+        else {
+            cerr << "Unknown or incomplete argument '" << arg << "'" << endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    /* Render farm worker: everything else comes from the coordinator */
+    if (!worker_address.empty())
+        return run_render_worker(worker_address, threads) ? 0 : 1;
+
+    /* Load scene */
+    scene_description scene;
+    string scene_data;  // sent to render farm workers as is, and identifies the scene in checkpoints
+    if (scene_file.empty())
+        scene_data = demo_scene;
+    else if (!listen_address.empty() || !checkpoint_file.empty()) {
+        ifstream in(scene_file, ios::binary);
+        stringstream contents;
+        contents << in.rdbuf();
+        scene_data = contents.str();
+    }
+    bool loaded = scene_file.empty() ? parse_scene_text(demo_scene, demo_scene + strlen(demo_scene), scene, "demo scene")
+                                     : load_scene(scene_file, scene);
+    if (!loaded) return 1;
+
+    if (!binary_file.empty())
+        return write_scene_binary(binary_file, scene) ? 0 : 1;
+
+    // Command line settings override the scene's
+    if (width > 0) {
+        if (scene.image_height > 0 && height <= 0)  // keep the scene's aspect ratio
+            scene.image_height = (int) (width * (double) scene.image_height / scene.image_width);
+        scene.image_width = width;
+    }
+    if (height > 0) scene.image_height = height;
+    if (spp > 0)    scene.samples_per_pixel = spp;
+    if (depth > 0)  scene.bounce_depth = depth;
 
     /* Initialize renderer */
     renderer r;
-
-    /* Camera setup */
-    point3 lookfrom = point3(1, 0, 0.1);
-    point3 lookat = point3(0,0,-1);
-
-    auto l = cos(3.14159/4);
-    point3 focusat = point3(l,0.0,-1.0);
-
-    r.cam = camera(lookfrom, lookat, focusat, y_hat(), 16.0/9.0, 70, 0.05);
-
-    /* Materials specifications */
-    matte::ptr material_ground = make_shared<matte>(color(0.8, 0.8, 0.0));
-    matte::ptr material_center = make_shared<matte>(color(0.4));
-    metal::ptr material_left   = make_shared<metal>(color(0.8, 0.8, 0.8), 0.1);
-    metal::ptr material_right  = make_shared<metal>(color(0.8, 0.6, 0.2), 0.2);
-
-    /* Create world and add shaded objects */
-    r.world = hittable_list();
-    r.world.add(make_shared<sphere>(point3( 0.0, -100.5*l, -1.0), 100.0*l, material_ground));
-    r.world.add(make_shared<sphere>(point3( 0.0,    0.0, -1.0),   0.45*l, material_center));
-    r.world.add(make_shared<sphere>(point3(-l,    0.0, -1.0),   0.5*l, material_left));
-    r.world.add(make_shared<sphere>(point3( l,    0.0, -1.0),   0.5*l, material_right));
+    r.cam = scene.make_camera();
+    r.world = scene.world;
+    r.build_bvh();
 
     /* Render quality specifications */
-    r.core_count = thread::hardware_concurrency();
-    r.samples_per_pixel = 10;
-    r.bounce_depth = 50;
+    r.core_count = max(threads, 1);
+    r.samples_per_pixel = scene.samples_per_pixel;
+    r.bounce_depth = scene.bounce_depth;
+    r.background = scene.background;
+    r.wavefront = wavefront;
+    r.sampling = sampling;
+    r.denoise = denoise;
+    r.write_aovs = aovs;
+    r.checkpoint_file = checkpoint_file;
+    r.checkpoint_interval = checkpoint_interval;
+    r.resume = resume;
+    r.scene_hash = scene_hash(scene_data.data(), scene_data.size());
+    if (resume && checkpoint_file.empty()) {
+        cerr << "--resume needs the --checkpoint file to resume from" << endl;
+        return 1;
+    }
 
     /* Output file specifications */
-    r.image_width = 1280;
-    r.image_height = r.image_width / r.cam.aspect_ratio; // image & viewport have same aspect ratio
+    r.image_width = scene.image_width;
+    r.image_height = scene.height();
 
     /* Render */
 
     /* For rendering video frames, try the code below (commented out currently) */
 
       /*
+      auto l = cos(3.14159/4);
+
       r.render_straight_line(point3(0,0,1), video_params(1, 30));
 
       spinning_circle_params scp = {
@@ -61,18 +176,35 @@ int main() {
 
       r.render_shifting_focus(r.cam.focus_dist*r.cam.view_dir, point3(l,0,-1), video_params(3, 30));
 
-      r.render_to_file("mt_test.ppm");
-
       // The output frames can be combined into an mp4 with the follwoing command: ffmpeg -framerate 30 -i "output/%01d.ppm" output.mp4
       */
 
-    /* Render live to a window */
-    r.render_to_window();
-
-    /* Render into a file */
-        /*
-        r.render_to_file("scene.ppm");
-        */
+    std::vector<camera> orbit;
+    if (orbit_seconds > 0) {
+        // Full circle around the look-at point, about the scene's up direction
+        vec3 up = unit_vector(scene.cam.vup);
+        vec3 e1 = unit_vector(cross(up, r.cam.view_dir));
+        spinning_circle_params scp = { e1, cross(up, e1), scene.cam.lookat, 2*pi, video_params(orbit_seconds, 30) };
+        orbit = r.spinning_circle_path(scp);
+    }
+
+    if (!listen_address.empty()) {
+        /* Hand the render out to farm workers */
+        render_farm farm(r, scene_data);
+        if (!farm.listen(listen_address)) return 1;
+        if (orbit_seconds > 0)
+            farm.render_frames(orbit);
+        else
+            farm.render_to_file(output == "window" ? "render.ppm" : output);
+    }
+    else if (orbit_seconds > 0)
+        r.render_frames(orbit);
+    else if (output == "window")
+        /* Render live to a window */
+        r.render_to_window();
+    else
+        /* Render into a file */
+        r.render_to_file(output);
 
     return 0;
-}
\ No newline at end of file
+}
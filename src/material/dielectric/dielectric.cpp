@@ -5,32 +5,32 @@ dielectric::dielectric(double n) {
   refractive_index = n;
 }
 
-double dielectric::reflectance(double n1, double n2, double theta1) {
-  double r0 = pow(((n1-n2)/(n1+n2)), 2);
-  return r0 + (1.0-r0)*pow((1-std::cos(theta1)), 5);
+/* Schlick's approximation of the Fresnel reflectance, for relative index eta = n1/n2. 'cosine' is the cosine of the angle on
+   the optically thinner side of the interface, so the approximation holds for rays leaving the glass too. */
+double dielectric::reflectance(double cosine, double eta) {
+  double r0 = (1 - eta) / (1 + eta);
+  r0 = r0*r0;
+  double m = 1 - cosine;
+  double m2 = m*m;
+  return r0 + (1 - r0)*m2*m2*m;
 }
 
-// optimization needed of this function
+/* Reflects with probability equal to the Fresnel reflectance and refracts otherwise, so averaged over samples each hit
+   splits its light exactly as Fresnel says. Refraction uses Snell's law in vector form: with unit incident direction d,
+   normal n facing it and cos_i = -d.n, the refracted direction is eta*d + (eta*cos_i - cos_t)*n, where
+   cos_t = sqrt(1 - eta^2 (1 - cos_i^2)). A negative radicand means total internal reflection. No trig needed. */
 ray dielectric::scatter(const ray& r_in, const hit_record& rec) const {
-  double n1 = rec.is_front_face ? 1.0 : refractive_index;
-  double n2 = rec.is_front_face ? refractive_index : 1.0;
+  double eta = rec.is_front_face ? 1.0/refractive_index : refractive_index;
 
-  double theta1 = angle_bw(-r_in.direction(), rec.normal);
-  double theta2 = std::asin((n1/n2)*std::sin(theta1));
+  vec3 d = unit_vector(r_in.direction());
+  double cos_i = std::min<double>(-dot(d, rec.normal), 1.0);
+  double sin2_t = eta*eta*(1 - cos_i*cos_i);
+  if (sin2_t >= 1)  // total internal reflection
+    return ray(rec.p, reflect(d, rec.normal));
 
-  if (rec.is_front_face && reflectance(n1, n2, theta1) > 0.3) // play around with this number
-    return ray(rec.p, reflect(r_in.direction(), rec.normal));
+  double cos_t = std::sqrt(1 - sin2_t);
+  if (random_double() < reflectance(eta < 1 ? cos_i : cos_t, eta))
+    return ray(rec.p, reflect(d, rec.normal));
 
-  vec3 tangent = unit_vector(r_in.direction() + r_in.direction().length()*std::cos(theta1)*rec.normal);
-
-  bool tir = false;
-  if (theta2 > 1.570795) {  // total internal reflection
-    theta2 = theta2 - 1.570795;
-	tir = true;
-  }   
-
-  vec3 t_perp = std::cos(theta2)*rec.normal;
-  vec3 t_par = std::sin(theta2)*tangent;
-
-  return tir ? ray(rec.p, t_perp + t_par) : ray(rec.p, -t_perp + t_par);
-}
\ No newline at end of file
+  return ray(rec.p, eta*d + (eta*cos_i - cos_t)*rec.normal);
+}
@@ -14,5 +14,5 @@ class dielectric : public material {
     double refractive_index;
 
   private:
-    static double reflectance(double n1, double n2, double theta1);
-};
\ No newline at end of file
+    static double reflectance(double cosine, double eta);
+};
@@ -0,0 +1,15 @@
+#include "emissive.h"
+
+emissive::emissive(color l) {
+  albedo = color(0,0,0);
+  radiance = l;
+}
+
+// Never continues a path (the renderer stops at emitters); returns the normal only to satisfy the interface
+ray emissive::scatter(const ray& /*r_in*/, const hit_record& rec) const {
+  return ray(rec.p, rec.normal);
+}
+
+color emissive::emitted() const {
+  return radiance;
+}
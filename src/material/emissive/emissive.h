@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../material.h"
+#include "../../hittable/hit_record/hit_record.h"
+
+/* Light source: emits radiance uniformly from the surface and reflects nothing */
+class emissive : public material {
+  public:
+    typedef std::shared_ptr<emissive> ptr;
+
+    emissive(color radiance);
+    virtual ray scatter(const ray& r_in, const hit_record& rec) const override;
+    virtual color emitted() const override;
+
+  public:
+    color radiance;
+};
@@ -0,0 +1,17 @@
+#include "material.h"
+
+bool material::is_diffuse() const {
+  return false;
+}
+
+color material::eval(const hit_record& /*rec*/, const vec3& /*direction*/) const {
+  return color(0,0,0);
+}
+
+double material::pdf(const hit_record& /*rec*/, const vec3& /*direction*/) const {
+  return 0.0;
+}
+
+color material::emitted() const {
+  return color(0,0,0);
+}
@@ -8,6 +8,14 @@ class material {
 
     virtual ray scatter(const ray& r_in, const hit_record& rec) const = 0;  
 
+    /* Light sampling support. Materials whose scatter() draws from a proper density (is_diffuse()) report that density and
+       the matching BSDF value, so the renderer can combine scatter() with explicit light samples through MIS. Specular
+       materials keep the defaults and are only ever sampled through scatter(). */
+    virtual bool is_diffuse() const;
+    virtual color eval(const hit_record& rec, const vec3& direction) const;  // BSDF * cos(angle to normal)
+    virtual double pdf(const hit_record& rec, const vec3& direction) const;  // solid angle density of scatter() picking direction
+    virtual color emitted() const;  // radiance leaving the surface; emitting surfaces end paths instead of scattering
+
   public:
-    color albedo;
-};
\ No newline at end of file
+    color albedo;  // throughput factor of a scatter() sample (for diffuse materials, eval/pdf of the sampled direction)
+};
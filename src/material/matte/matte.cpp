@@ -4,7 +4,23 @@ matte::matte(color a) {
   albedo = a;
 }
 
+/* Lambertian: cosine-weighted direction around the normal (normal + uniform unit vector), so eval/pdf is exactly albedo */
 ray matte::scatter(const ray& r_in, const hit_record& rec) const {
-  point3 target = rec.p + rec.normal + random_in_unit_sphere();
-  return ray(rec.p, target - rec.p);
-}
\ No newline at end of file
+  vec3 direction = rec.normal + random_unit_vector();
+  if (direction.length_squared() < 1e-16) direction = rec.normal;  // unit vector opposite the normal
+  return ray(rec.p, direction);
+}
+
+bool matte::is_diffuse() const {
+  return true;
+}
+
+color matte::eval(const hit_record& rec, const vec3& direction) const {
+  double cosine = dot(rec.normal, unit_vector(direction));
+  return cosine > 0 ? albedo * (cosine / pi) : color(0,0,0);
+}
+
+double matte::pdf(const hit_record& rec, const vec3& direction) const {
+  double cosine = dot(rec.normal, unit_vector(direction));
+  return cosine > 0 ? cosine / pi : 0.0;
+}
@@ -10,4 +10,8 @@ class matte : public material {
 
     matte(color a);
     virtual ray scatter(const ray& r_in, const hit_record& rec) const override;
-};
\ No newline at end of file
+
+    virtual bool is_diffuse() const override;
+    virtual color eval(const hit_record& rec, const vec3& direction) const override;
+    virtual double pdf(const hit_record& rec, const vec3& direction) const override;
+};
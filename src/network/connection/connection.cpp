@@ -0,0 +1,264 @@
+#include "connection.h"
+
+#include <cstring>
+#include <functional>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#endif
+
+struct message_header {
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t size;
+};
+
+static_assert(sizeof(message_header) == 16, "message_header must have no padding");
+
+#ifndef _WIN32
+
+static const size_t max_message_size = size_t(1) << 36;  // anything bigger is a corrupt header
+
+/* Splits "unix:<path>" or "[host]:port" */
+static bool parse_address(const std::string& address, bool& is_unix, std::string& host, std::string& port) {
+  if (address.compare(0, 5, "unix:") == 0) {
+    is_unix = true;
+    host = address.substr(5);
+    return !host.empty() && host.size() < sizeof(sockaddr_un::sun_path);
+  }
+  is_unix = false;
+  size_t colon = address.rfind(':');
+  if (colon == std::string::npos || colon + 1 == address.size()) return false;
+  host = address.substr(0, colon);
+  port = address.substr(colon + 1);
+  return true;
+}
+
+static sockaddr_un unix_address(const std::string& path) {
+  sockaddr_un a = {};
+  a.sun_family = AF_UNIX;
+  strncpy(a.sun_path, path.c_str(), sizeof(a.sun_path) - 1);
+  return a;
+}
+
+/* Sockets for TCP connections: no Nagle delay, since messages are written whole */
+static void set_tcp_options(int fd) {
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/* Writing to a peer that went away must fail the send, not raise SIGPIPE and kill the process: Linux has MSG_NOSIGNAL
+   for that, macOS and the BSDs a socket option */
+#ifdef MSG_NOSIGNAL
+static const int send_flags = MSG_NOSIGNAL;
+#else
+static const int send_flags = 0;
+#endif
+
+connection::connection(int f): fd(f) {
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+connection::~connection() {
+  if (fd >= 0) ::close(fd);
+}
+
+connection::ptr connection::connect(const std::string& address) {
+  bool is_unix;
+  std::string host, port;
+  if (!parse_address(address, is_unix, host, port)) {
+    std::cerr << "Bad address '" << address << "' (expected host:port or unix:<path>)" << std::endl;
+    return nullptr;
+  }
+
+  if (is_unix) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un a = unix_address(host);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a)) == 0) return std::make_shared<connection>(fd);
+    std::cerr << "Could not connect to '" << address << "': " << strerror(errno) << std::endl;
+    if (fd >= 0) ::close(fd);
+    return nullptr;
+  }
+
+  addrinfo hints = {}, *found = nullptr;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int err = getaddrinfo(host.empty() ? "localhost" : host.c_str(), port.c_str(), &hints, &found);
+  if (err != 0) {
+    std::cerr << "Could not resolve '" << address << "': " << gai_strerror(err) << std::endl;
+    return nullptr;
+  }
+  int fd = -1;
+  for (addrinfo* a = found; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(found);
+  if (fd < 0) {
+    std::cerr << "Could not connect to '" << address << "': " << strerror(errno) << std::endl;
+    return nullptr;
+  }
+  set_tcp_options(fd);
+  return std::make_shared<connection>(fd);
+}
+
+static bool send_all(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::send(fd, data, size, send_flags);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool connection::send(uint32_t type, const void* payload, size_t size) {
+  message_header h = {type, 0, size};
+  return send_all(fd, reinterpret_cast<const char*>(&h), sizeof(h)) && send_all(fd, static_cast<const char*>(payload), size);
+}
+
+bool connection::send(uint32_t type, const std::vector<char>& payload) {
+  return send(type, payload.data(), payload.size());
+}
+
+bool connection::wait_readable(double timeout) {
+  if (timeout <= 0) return true;
+  pollfd p = {fd, POLLIN, 0};
+  int n;
+  do n = poll(&p, 1, static_cast<int>(timeout * 1000)); while (n < 0 && errno == EINTR);
+  return n > 0;
+}
+
+/* Reads exactly size bytes, allowing timeout seconds of silence between chunks */
+static bool receive_all(int fd, char* data, size_t size, const std::function<bool()>& wait) {
+  while (size > 0) {
+    if (!wait()) return false;
+    ssize_t n = ::recv(fd, data, size, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool connection::receive(uint32_t& type, std::vector<char>& payload, double timeout) {
+  auto wait = [&] { return wait_readable(timeout); };
+  message_header h;
+  if (!receive_all(fd, reinterpret_cast<char*>(&h), sizeof(h), wait) || h.size > max_message_size) return false;
+  type = h.type;
+  payload.resize(h.size);
+  return receive_all(fd, payload.data(), payload.size(), wait);
+}
+
+void connection::shutdown() {
+  ::shutdown(fd, SHUT_RDWR);
+}
+
+listener::listener(): fd(-1) {}
+
+listener::~listener() {
+  close();
+}
+
+bool listener::listen(const std::string& address) {
+  bool is_unix;
+  std::string host, port;
+  if (!parse_address(address, is_unix, host, port)) {
+    std::cerr << "Bad address '" << address << "' (expected [host]:port or unix:<path>)" << std::endl;
+    return false;
+  }
+
+  if (is_unix) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un a = unix_address(host);
+    unlink(host.c_str());  // left over from an earlier run
+    if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&a), sizeof(a)) == 0 && ::listen(fd, 64) == 0) {
+      unix_path = host;
+      return true;
+    }
+  } else {
+    addrinfo hints = {}, *found = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    int err = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found);
+    if (err != 0) {
+      std::cerr << "Could not resolve '" << address << "': " << gai_strerror(err) << std::endl;
+      return false;
+    }
+    for (addrinfo* a = found; a != nullptr && fd < 0; a = a->ai_next) {
+      fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      int one = 1;
+      if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      if (fd >= 0 && (bind(fd, a->ai_addr, a->ai_addrlen) != 0 || ::listen(fd, 64) != 0)) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+    freeaddrinfo(found);
+    if (fd >= 0) return true;
+  }
+
+  std::cerr << "Could not listen on '" << address << "': " << strerror(errno) << std::endl;
+  close();
+  return false;
+}
+
+connection::ptr listener::accept(double timeout) {
+  pollfd p = {fd, POLLIN, 0};
+  if (fd < 0 || poll(&p, 1, static_cast<int>(timeout * 1000)) <= 0) return nullptr;
+  int c = ::accept(fd, nullptr, nullptr);
+  if (c < 0) return nullptr;
+  if (unix_path.empty()) set_tcp_options(c);
+  return std::make_shared<connection>(c);
+}
+
+void listener::close() {
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+  if (!unix_path.empty()) unlink(unix_path.c_str());
+  unix_path.clear();
+}
+
+#else
+
+connection::connection(int f): fd(f) {}
+connection::~connection() {}
+
+connection::ptr connection::connect(const std::string& address) {
+  std::cerr << "Sockets are not supported on this platform" << std::endl;
+  return nullptr;
+}
+
+bool connection::send(uint32_t, const void*, size_t) { return false; }
+bool connection::send(uint32_t, const std::vector<char>&) { return false; }
+bool connection::wait_readable(double) { return false; }
+bool connection::receive(uint32_t&, std::vector<char>&, double) { return false; }
+void connection::shutdown() {}
+
+listener::listener(): fd(-1) {}
+listener::~listener() {}
+
+bool listener::listen(const std::string& address) {
+  std::cerr << "Sockets are not supported on this platform" << std::endl;
+  return false;
+}
+
+connection::ptr listener::accept(double) { return nullptr; }
+void listener::close() {}
+
+#endif
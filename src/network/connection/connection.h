@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+/*
+  Blocking stream sockets carrying whole messages: a 16 byte header (type, payload size) followed by the payload.
+  Addresses are "host:port" for TCP (host may be left out when listening, to listen on all interfaces) or
+  "unix:<path>" for a Unix domain socket. POSIX only; elsewhere every call fails.
+*/
+class connection {
+  public:
+    typedef std::shared_ptr<connection> ptr;
+
+    connection(int fd);
+    ~connection();
+
+    static ptr connect(const std::string& address);  // null (with a message on std::cerr) on failure
+
+    bool send(uint32_t type, const void* payload, size_t size);
+    bool send(uint32_t type, const std::vector<char>& payload);
+    // Waits up to timeout seconds (forever if <= 0) for the next message. False on timeout, error or a closed connection.
+    bool receive(uint32_t& type, std::vector<char>& payload, double timeout = 0);
+    void shutdown();  // makes pending and future send/receive calls on any thread fail
+
+  private:
+    bool wait_readable(double timeout);
+
+  private:
+    int fd;
+};
+
+/* Listening socket that accepts connections */
+class listener {
+  public:
+    listener();
+    ~listener();
+
+    bool listen(const std::string& address);  // false (with a message on std::cerr) on failure
+    connection::ptr accept(double timeout);   // null if nothing connected within timeout seconds
+    void close();
+
+  private:
+    int fd;
+    std::string unix_path;  // removed again on close()
+};
@@ -0,0 +1,67 @@
+#include "camera_controller.h"
+
+/* Rotates v by angle (radians) around the unit axis k (Rodrigues' formula) */
+static vec3 rotate(const vec3& v, const vec3& k, double angle) {
+  double c = std::cos(angle), s = std::sin(angle);
+  return v*c + cross(k, v)*s + k*dot(k, v)*(1 - c);
+}
+
+camera_controller::camera_controller(const camera& cam): up(unit_vector(cam.y)) {
+  move_fraction = 0.05;
+  orbit_step = 0.05;
+  drag_speed = 0.005;
+  focus_step = 1.1;
+}
+
+bool camera_controller::handle_event(const SDL_Event& e, camera& cam) {
+  vec3 right = unit_vector(cross(cam.view_dir, up));
+
+  if (e.type == SDL_KEYDOWN) {
+    switch (e.key.keysym.sym) {
+      case SDLK_w:     move(cam,  cam.view_dir); return true;
+      case SDLK_s:     move(cam, -cam.view_dir); return true;
+      case SDLK_d:     move(cam,  right);        return true;
+      case SDLK_a:     move(cam, -right);        return true;
+      case SDLK_e:     move(cam,  up);           return true;
+      case SDLK_q:     move(cam, -up);           return true;
+      case SDLK_LEFT:  orbit(cam, -orbit_step, 0); return true;
+      case SDLK_RIGHT: orbit(cam,  orbit_step, 0); return true;
+      case SDLK_UP:    orbit(cam, 0,  orbit_step); return true;
+      case SDLK_DOWN:  orbit(cam, 0, -orbit_step); return true;
+      default: return false;
+    }
+  }
+
+  if (e.type == SDL_MOUSEMOTION && (e.motion.state & SDL_BUTTON_LMASK)) {
+    orbit(cam, -e.motion.xrel*drag_speed, e.motion.yrel*drag_speed);
+    return e.motion.xrel != 0 || e.motion.yrel != 0;
+  }
+
+  if (e.type == SDL_MOUSEWHEEL && e.wheel.y != 0) {
+    double scale = std::pow(focus_step, e.wheel.y);
+    cam.focus(cam.origin + cam.view_dir*(cam.focus_dist*scale));
+    return true;
+  }
+
+  return false;
+}
+
+/* Translates the camera and its look-at point together, so orbiting afterwards stays centred in front of it */
+void camera_controller::move(camera& cam, const vec3& direction) const {
+  double step = move_fraction * (cam.lookat - cam.origin).length();
+  cam.pan(direction, step);
+  cam.lookat += unit_vector(direction)*step;
+}
+
+void camera_controller::orbit(camera& cam, double yaw, double pitch) const {
+  vec3 offset = cam.origin - cam.lookat;
+  offset = rotate(offset, up, yaw);
+
+  // Don't pitch over the pole, where the view direction would line up with world up
+  vec3 right = unit_vector(cross(-offset, up));
+  vec3 pitched = rotate(offset, right, pitch);
+  if (std::fabs(dot(unit_vector(pitched), up)) < 0.99)
+    offset = pitched;
+
+  cam.orient(cam.lookat + offset, cam.lookat, up);
+}
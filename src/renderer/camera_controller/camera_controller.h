@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../../camera/camera.h"
+
+/* Turns SDL keyboard & mouse input into camera moves for the interactive window:
+     W/S, A/D, Q/E   move forward/back, left/right, down/up (camera::pan)
+     arrows, drag    orbit around the look-at point (camera::orient)
+     mouse wheel     move the focus plane nearer/farther (camera::focus)
+   Step sizes scale with the distance to the look-at point, so navigation feels the same at any scene scale. */
+class camera_controller {
+  public:
+    camera_controller(const camera& cam);
+
+    bool handle_event(const SDL_Event& e, camera& cam);  // returns true if cam was changed
+
+  private:
+    void move(camera& cam, const vec3& direction) const;
+    void orbit(camera& cam, double yaw, double pitch) const;
+
+  public:
+    vec3 up;               // world up, taken from the camera at construction
+    double move_fraction;  // per key press, as a fraction of the distance to the look-at point
+    double orbit_step;     // radians per arrow key press
+    double drag_speed;     // radians per pixel of mouse drag
+    double focus_step;     // focus distance scale per wheel notch
+};
@@ -0,0 +1,154 @@
+#include "denoiser.h"
+
+#include <algorithm>
+
+denoiser::denoiser() {
+  iterations = 5;
+  color_sigma = 4.0;
+  normal_power = 128.0;
+  depth_sigma = 0.02;
+  albedo_sigma = 0.1;
+}
+
+/* Runs rows(y0, y1) on every worker of the pool over its share of [0, height) and waits for all of them */
+static void parallel_rows(thread_pool& pool, int height, const std::function<void(int, int)>& rows) {
+  const int workers = pool.size();
+  pool.run([&](int worker) { rows(height*worker/workers, height*(worker + 1)/workers); }).wait();
+}
+
+static float lum(float r, float g, float b) {
+  return 0.2126f*r + 0.7152f*g + 0.0722f*b;
+}
+
+/* Demodulated radiance and its variance, one plane each */
+struct illumination {
+  std::vector<float> r, g, b, var;
+  illumination(int n): r(n), g(n), b(n), var(n) {}
+};
+
+/* Guide features per pixel: mean albedo (clamped away from 0 so it can be divided by), unit normal (0 for misses) and depth */
+struct features {
+  std::vector<float> ar, ag, ab, nx, ny, nz, depth;
+  features(int n): ar(n), ag(n), ab(n), nx(n), ny(n), nz(n), depth(n) {}
+};
+
+void denoiser::apply(const image& in, accum_buffer& out, thread_pool& pool) const {
+  const int width = in.width, height = in.height, size = width*height;
+  const accum_buffer& acc = in.accum;
+  features f(size);
+  illumination ping(size), pong(size);
+  std::vector<float> sample_lum(size), sample_var(size);  // per pixel mean & variance of the mean of demodulated luminance
+  std::vector<uint32_t> counts(acc.count);
+
+  // Gather: demodulate, and estimate each pixel's noise from the spread of its samples
+  parallel_rows(pool, height, [&](int y0, int y1) {
+    for (int i = y0*width; i < y1*width; ++i) {
+      aov_sample a = in.aov.mean(i);
+      f.ar[i] = static_cast<float>(std::max<double>(a.albedo.R(), 0.01));
+      f.ag[i] = static_cast<float>(std::max<double>(a.albedo.G(), 0.01));
+      f.ab[i] = static_cast<float>(std::max<double>(a.albedo.B(), 0.01));
+      double len = a.normal.length();
+      vec3 n = len > 0 ? a.normal / len : vec3(0,0,0);
+      f.nx[i] = static_cast<float>(n.x());
+      f.ny[i] = static_cast<float>(n.y());
+      f.nz[i] = static_cast<float>(n.z());
+      f.depth[i] = static_cast<float>(a.depth);
+
+      color c = acc.mean(i);
+      ping.r[i] = static_cast<float>(c.R()) / f.ar[i];
+      ping.g[i] = static_cast<float>(c.G()) / f.ag[i];
+      ping.b[i] = static_cast<float>(c.B()) / f.ab[i];
+      sample_lum[i] = static_cast<float>(a.lum);
+      sample_var[i] = counts[i] > 1 ? static_cast<float>(std::max(a.lum2 - a.lum*a.lum, 0.0) / counts[i]) : 0.0f;
+    }
+  });
+
+  // Smooth the noise estimate over 3x3 pixels. With fewer than 4 samples the per-pixel spread means little, so the
+  // spread of the neighbourhood's pixel values is used instead.
+  parallel_rows(pool, height, [&](int y0, int y1) {
+    for (int y = y0; y < y1; ++y)
+      for (int x = 0; x < width; ++x) {
+        const int p = y*width + x;
+        float sum = 0, sum2 = 0, weighted = 0, weights = 0;
+        int taps = 0;
+        for (int dy = -1; dy <= 1; ++dy)
+          for (int dx = -1; dx <= 1; ++dx) {
+            int qx = x + dx, qy = y + dy;
+            if (qx < 0 || qx >= width || qy < 0 || qy >= height) continue;
+            int q = qy*width + qx;
+            float w = (dx == 0 ? 2.0f : 1.0f) * (dy == 0 ? 2.0f : 1.0f);
+            weighted += w*sample_var[q];
+            weights += w;
+            sum += sample_lum[q];
+            sum2 += sample_lum[q]*sample_lum[q];
+            ++taps;
+          }
+        ping.var[p] = counts[p] >= 4 ? weighted / weights : std::max(sum2/taps - (sum/taps)*(sum/taps), 0.0f);
+      }
+  });
+
+  // À-trous steps, each reading one buffer and writing the other
+  static const float kernel[5] = {1.0f/16, 1.0f/4, 3.0f/8, 1.0f/4, 1.0f/16};
+  const float inv_albedo_sigma2 = static_cast<float>(1.0 / (albedo_sigma*albedo_sigma));
+  illumination* src = &ping;
+  illumination* dst = &pong;
+  for (int it = 0; it < iterations; ++it) {
+    const int step = 1 << it;
+    const float depth_scale = static_cast<float>(depth_sigma) * step;
+    parallel_rows(pool, height, [&](int y0, int y1) {
+      const illumination& s = *src;
+      illumination& d = *dst;
+      for (int y = y0; y < y1; ++y)
+        for (int x = 0; x < width; ++x) {
+          const int p = y*width + x;
+          const float lp = lum(s.r[p], s.g[p], s.b[p]);
+          const float inv_lum_sigma = 1.0f / (static_cast<float>(color_sigma)*std::sqrt(s.var[p]) + 1e-4f);
+          const float inv_depth_sigma = 1.0f / (depth_scale*f.depth[p] + 1e-4f);
+          const bool missed = f.nx[p] == 0 && f.ny[p] == 0 && f.nz[p] == 0;
+          float r = 0, g = 0, b = 0, var = 0, weights = 0;
+          for (int ky = 0; ky < 5; ++ky) {
+            int qy = y + (ky - 2)*step;
+            if (qy < 0 || qy >= height) continue;
+            for (int kx = 0; kx < 5; ++kx) {
+              int qx = x + (kx - 2)*step;
+              if (qx < 0 || qx >= width) continue;
+              const int q = qy*width + qx;
+
+              float cos_n = f.nx[p]*f.nx[q] + f.ny[p]*f.ny[q] + f.nz[p]*f.nz[q];
+              float wn = missed ? (f.nx[q] == 0 && f.ny[q] == 0 && f.nz[q] == 0 ? 1.0f : 0.0f)
+                                : std::pow(std::max(cos_n, 0.0f), static_cast<float>(normal_power));
+              if (wn <= 0) continue;
+              float da_r = f.ar[p] - f.ar[q], da_g = f.ag[p] - f.ag[q], da_b = f.ab[p] - f.ab[q];
+              float e = std::fabs(lp - lum(s.r[q], s.g[q], s.b[q])) * inv_lum_sigma
+                      + std::fabs(f.depth[p] - f.depth[q]) * inv_depth_sigma
+                      + (da_r*da_r + da_g*da_g + da_b*da_b) * inv_albedo_sigma2;
+              float w = kernel[kx]*kernel[ky] * wn * std::exp(-e);
+
+              r += w*s.r[q];
+              g += w*s.g[q];
+              b += w*s.b[q];
+              var += w*w*s.var[q];
+              weights += w;
+            }
+          }
+          // The center tap always has weight kernel[2]^2 > 0
+          d.r[p] = r / weights;
+          d.g[p] = g / weights;
+          d.b[p] = b / weights;
+          d.var[p] = var / (weights*weights);
+        }
+    });
+    std::swap(src, dst);
+  }
+
+  // Modulate the albedo back in and store as sums over the original sample counts
+  parallel_rows(pool, height, [&](int y0, int y1) {
+    for (int i = y0*width; i < y1*width; ++i) {
+      float n = static_cast<float>(counts[i]);
+      out.r[i] = src->r[i]*f.ar[i]*n;
+      out.g[i] = src->g[i]*f.ag[i]*n;
+      out.b[i] = src->b[i]*f.ab[i]*n;
+      out.count[i] = counts[i];
+    }
+  });
+}
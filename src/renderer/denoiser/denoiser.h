@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../image/image.h"
+#include "../thread_pool/thread_pool.h"
+
+/* Edge-avoiding à-trous wavelet denoiser guided by the image's first-hit features (Dammertz et al. 2010, with the
+   variance-guided luminance weight of SVGF, Schied et al. 2017).
+
+   The radiance of every pixel is first divided by its albedo, so that texture and material colors are not blurred, only
+   the lighting. The result is then filtered 'iterations' times with a 5x5 B3-spline kernel whose taps are spread 1, 2, 4,
+   ... pixels apart, which reaches far with few taps. Each tap is weighted down where the features say it lies across an
+   edge: a different normal, depth or albedo, or a luminance difference larger than the pixel's noise (estimated from the
+   spread of its samples and carried through the iterations). Finally the albedo is multiplied back in.
+
+   The rows of each step are split between the thread pool's workers. */
+class denoiser {
+  public:
+    denoiser();
+
+    /* Filters in's radiance into out, which must have in's dimensions. out may be in.accum (in place); sample counts are kept. */
+    void apply(const image& in, accum_buffer& out, thread_pool& pool) const;
+
+  public:
+    int iterations;        // filter steps; the footprint is 4*2^iterations - 3 pixels wide
+    double color_sigma;    // luminance differences are compared to color_sigma standard deviations of the pixel's noise
+    double normal_power;   // normal weight is dot(n_p, n_q)^normal_power
+    double depth_sigma;    // relative depth difference per pixel of tap distance that halves a weight (roughly)
+    double albedo_sigma;
+};
@@ -0,0 +1,224 @@
+#include "render_checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(checkpoint_header) == 168, "checkpoint_header must have no padding");
+static_assert(std::is_trivially_copyable<camera>::value, "cameras are stored as raw bytes");
+
+static const char checkpoint_magic[8] = {'R', 'T', 'W', 'C', 'K', 'P', 'T', '1'};
+static const uint32_t checkpoint_version = 2;
+static const size_t page_size = 4096;
+
+render_checkpoint::render_checkpoint(): data(nullptr), size(0), mapped(false), was_resumed(false), width(0), height(0) {}
+
+render_checkpoint::~render_checkpoint() {
+#ifndef _WIN32
+    if (mapped) munmap(data, size);
+#endif
+}
+
+checkpoint_header& render_checkpoint::header() const {
+    return *reinterpret_cast<checkpoint_header*>(data);
+}
+
+uint8_t* render_checkpoint::flags() const {
+    return reinterpret_cast<uint8_t*>(data + sizeof(checkpoint_header) + sizeof(camera));
+}
+
+char* render_checkpoint::plane(int index) const {
+    return data + header().data_offset + static_cast<size_t>(index) * width * height * sizeof(float);
+}
+
+bool render_checkpoint::open(const std::string& file, const render_settings& settings, uint64_t scene_hash, int total_frames, bool resume) {
+    filename = file;
+    width = settings.image_width;
+    height = settings.image_height;
+    grid = std::make_unique<tile_scheduler>(width, height, settings.tile_size, 1);
+
+    checkpoint_header expected = {};
+    memcpy(expected.magic, checkpoint_magic, sizeof(checkpoint_magic));
+    expected.version = checkpoint_version;
+    expected.real_size = sizeof(real);
+    expected.camera_size = sizeof(camera);
+    expected.tile_count = grid->grid_size();
+    expected.total_frames = total_frames;
+    image probe(1, 1);
+    if (settings.features) probe.aov.allocate();
+    size_t planes = probe.float_planes().size() + probe.count_planes().size();  // every plane is 4 bytes a pixel
+    expected.data_offset = (sizeof(checkpoint_header) + sizeof(camera) + expected.tile_count + page_size - 1) / page_size * page_size;
+    expected.file_size = expected.data_offset + planes * width * height * sizeof(float);
+    expected.scene_hash = scene_hash;
+    expected.settings = settings;
+
+    size = expected.file_size;
+    was_resumed = false;
+    if (resume && map(false)) {
+        if (valid(expected)) {
+            was_resumed = true;
+            return true;
+        }
+        std::cerr << "Checkpoint '" << filename << "' is of a different render; starting over" << std::endl;
+    }
+    else if (resume)
+        std::cerr << "No checkpoint to resume in '" << filename << "'; starting over" << std::endl;
+
+    if (!map(true)) {
+        std::cerr << "Could not create checkpoint '" << filename << "'" << std::endl;
+        return false;
+    }
+    header() = expected;
+    flush(0, expected.data_offset, false);
+    return true;
+}
+
+/* Maps the file (size bytes), creating or truncating it first if asked */
+bool render_checkpoint::map(bool create) {
+#ifndef _WIN32
+    if (mapped) munmap(data, size);
+    mapped = false;
+    int fd = ::open(filename.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (fd >= 0) {
+        struct stat st;
+        bool sized = create ? ftruncate(fd, size) == 0 : (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size);
+        void* p = sized ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (p != MAP_FAILED) {
+            data = static_cast<char*>(p);
+            mapped = true;
+            return true;
+        }
+        if (!sized && !create) return false;  // some other file of this name
+    }
+#endif
+    buffer.assign(size, 0);
+    data = buffer.data();
+    if (create) return true;
+    std::ifstream in(filename, std::ios::binary);
+    return in.read(data, size) && in.peek() == EOF;
+}
+
+bool render_checkpoint::valid(const checkpoint_header& expected) const {
+    const checkpoint_header& h = header();
+    return memcmp(h.magic, expected.magic, sizeof(h.magic)) == 0 && h.version == expected.version &&
+           h.real_size == expected.real_size && h.camera_size == expected.camera_size &&
+           h.tile_count == expected.tile_count && h.total_frames == expected.total_frames &&
+           h.frame >= 0 && h.frame < std::max(h.total_frames, 1) && h.data_offset == expected.data_offset &&
+           h.file_size == expected.file_size && h.scene_hash == expected.scene_hash && memcmp(&h.settings, &expected.settings, sizeof(render_settings)) == 0;
+}
+
+/* Writes a byte range of the file to disk: synchronously when wait is set, so that later writes can rely on it */
+void render_checkpoint::flush(size_t offset, size_t length, bool wait) {
+#ifndef _WIN32
+    if (mapped) {
+        size_t start = offset / page_size * page_size;  // msync() takes page aligned addresses
+        msync(data + start, offset + length - start, wait ? MS_SYNC : MS_ASYNC);
+        return;
+    }
+#endif
+    if (data == nullptr || wait) return;  // ordering comes for free below
+    std::string temporary = filename + ".tmp";  // replaced in one step, so there is always a whole checkpoint on disk
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (out.write(data, size) && (out.close(), true))
+        std::rename(temporary.c_str(), filename.c_str());
+}
+
+bool render_checkpoint::resumed() const {
+    return was_resumed;
+}
+
+int render_checkpoint::frame() const {
+    return header().frame;
+}
+
+int render_checkpoint::passes() const {
+    return header().passes;
+}
+
+camera render_checkpoint::frame_camera() const {
+    camera c;
+    memcpy(&c, data + sizeof(checkpoint_header), sizeof(camera));
+    return c;
+}
+
+int render_checkpoint::tiles_done() const {
+    int done = 0;
+    for (int t = 0; t < header().tile_count; ++t) done += flags()[t];
+    return done;
+}
+
+void render_checkpoint::start_frame(int frame, const camera& cam) {
+    if (data == nullptr) return;
+    if (header().frame == frame && memcmp(data + sizeof(checkpoint_header), &cam, sizeof(camera)) == 0) return;
+    memset(flags(), 0, header().tile_count);
+    flush(0, header().data_offset, true);  // no tile may count as done for the new frame before its data is in
+    header().frame = frame;
+    header().passes = 0;
+    memcpy(data + sizeof(checkpoint_header), &cam, sizeof(camera));
+    flush(0, header().data_offset, false);
+}
+
+/* Copies a tile's rows of every plane between pixels and the file */
+void render_checkpoint::copy_tile(image& pixels, const tile& t, bool to_file) const {
+    size_t row = (t.x1 - t.x0) * sizeof(float);
+    int index = 0;
+    auto copy = [&](char* plane_data) {
+        char* file_plane = plane(index++);
+        for (int y = t.y0; y < t.y1; ++y) {
+            size_t offset = (static_cast<size_t>(y) * width + t.x0) * sizeof(float);
+            if (to_file) memcpy(file_plane + offset, plane_data + offset, row);
+            else memcpy(plane_data + offset, file_plane + offset, row);
+        }
+    };
+    for (std::vector<float>* p : pixels.float_planes()) copy(reinterpret_cast<char*>(p->data()));
+    for (std::vector<uint32_t>* p : pixels.count_planes()) copy(reinterpret_cast<char*>(p->data()));
+}
+
+void render_checkpoint::restore(image& pixels, std::vector<int>& remaining) const {
+    remaining.clear();
+    for (int index = 0; index < grid->grid_size(); ++index) {
+        if (data != nullptr && flags()[index]) copy_tile(pixels, grid->tile_at(index), false);
+        else remaining.push_back(index);
+    }
+}
+
+void render_checkpoint::save(image& pixels, const std::vector<tile>& finished) {
+    if (data == nullptr || finished.empty()) return;
+    for (const tile& t : finished) copy_tile(pixels, t, true);
+    flush(header().data_offset, size - header().data_offset, true);  // only the pages just written go out
+    for (const tile& t : finished) flags()[t.index] = 1;
+    flush(0, header().data_offset, false);
+}
+
+/* Only copies into the mapping (or buffer); the file gets it with the next write_passes() */
+void render_checkpoint::save_pass(image& pixels, int passes, const camera& cam) {
+    if (data == nullptr) return;
+    for (int index = 0; index < grid->grid_size(); ++index) copy_tile(pixels, grid->tile_at(index), true);
+    header().passes = passes;
+    memcpy(data + sizeof(checkpoint_header), &cam, sizeof(camera));
+    memset(flags(), 1, header().tile_count);
+}
+
+void render_checkpoint::write_passes() {
+    if (data == nullptr) return;
+    flush(0, size, false);
+}
+
+void render_checkpoint::remove() {
+#ifndef _WIN32
+    if (mapped) munmap(data, size);
+#endif
+    mapped = false;
+    data = nullptr;
+    buffer.clear();
+    std::remove(filename.c_str());
+}
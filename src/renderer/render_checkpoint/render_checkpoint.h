@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../renderer.h"
+
+/*
+  Checkpoint of a render in progress, so that an interrupted render can pick up where it left off.
+
+  The unit of progress is the tile: a tile's samples depend only on the seed and its pixels (the sample streams are
+  seeded per pixel and indexed by the pixel's sample count), so a resumed render that renders just the tiles missing from
+  the checkpoint ends up bit-identical to one that was never interrupted. Window renders, which refine the whole frame
+  one sample per pixel at a time, are checkpointed at the end of a pass instead.
+
+  File layout (native byte order), fixed by the render settings so the file can stay memory-mapped while rendering:
+    checkpoint_header
+    the camera of the frame in progress (sizeof(camera) bytes)
+    one byte per tile of the tile_size grid: 1 once the tile's data below is complete
+    (padding to data_offset)
+    the image's float planes (see image::float_planes()), then its two count planes, width*height values each
+
+  save() copies newly finished tiles into the mapping from the thread that polls the render, so the workers never wait
+  for it. Tile data is flushed to disk before the tiles are flagged, so a checkpoint interrupted halfway through being
+  written still only claims complete tiles. Where files can't be memory-mapped, the whole file is rewritten instead.
+  Window renders copy every finished pass into the mapping without waiting on the disk (save_pass()), and only ask for it
+  to be written out every checkpoint interval and on close (write_passes()): the UI thread never blocks on I/O, at the
+  price that a system crash, unlike the renderer being stopped, can leave a pass half written.
+*/
+struct checkpoint_header {
+  char magic[8];            // "RTWCKPT1"
+  uint32_t version;
+  uint32_t real_size;       // sizeof(real) of the build that wrote it
+  uint32_t camera_size;     // sizeof(camera)
+  int32_t tile_count;
+  int32_t frame;            // frame in progress, of total_frames (0 of 1 for stills)
+  int32_t total_frames;     // 0 for window renders
+  int32_t passes;           // window renders: complete one-sample passes over the frame
+  int32_t reserved;
+  uint64_t data_offset;     // byte offset of the first plane, a multiple of the page size
+  uint64_t file_size;
+  uint64_t scene_hash;      // of the scene file rendered, so that an edited scene doesn't pick up the old one's tiles
+  render_settings settings;
+};
+
+class render_checkpoint {
+  public:
+    render_checkpoint();
+    ~render_checkpoint();
+
+    // Starts checkpointing a render of the scene with this hash and these settings into filename. With resume, a checkpoint
+    // of the same render already in the file is kept (resumed() is then true); otherwise the file is started over.
+    bool open(const std::string& filename, const render_settings& settings, uint64_t scene_hash, int total_frames, bool resume);
+    bool resumed() const;
+    int frame() const;
+    int passes() const;
+    camera frame_camera() const;
+    int tiles_done() const;
+
+    void start_frame(int frame, const camera& cam);  // keeps the finished tiles if they are of this frame & camera
+    void restore(image& pixels, std::vector<int>& remaining) const;  // copies in finished tiles, lists the others
+    void save(image& pixels, const std::vector<tile>& finished);
+    void save_pass(image& pixels, int passes, const camera& cam);  // the whole frame, after passes complete passes
+    void write_passes();  // starts writing the saved pass out to disk, without waiting for it
+    void remove();  // deletes the file once the render it belongs to is complete
+
+  private:
+    bool map(bool create);
+    bool valid(const checkpoint_header& expected) const;
+    void flush(size_t offset, size_t size, bool wait);
+    checkpoint_header& header() const;
+    uint8_t* flags() const;
+    char* plane(int index) const;
+    void copy_tile(image& pixels, const tile& t, bool to_file) const;
+
+  private:
+    std::string filename;
+    char* data;                 // the mapping, or buffer's contents
+    size_t size;
+    std::vector<char> buffer;   // file contents where it isn't mapped
+    bool mapped;
+    bool was_resumed;
+    std::unique_ptr<tile_scheduler> grid;  // geometry of the tile grid (tile_at())
+    int width, height;
+};
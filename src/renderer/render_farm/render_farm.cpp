@@ -0,0 +1,359 @@
+#include "render_farm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+static const char farm_magic[8] = {'R', 'T', 'W', 'F', 'A', 'R', 'M', '1'};
+static const uint32_t farm_version = 1;
+
+static_assert(std::is_trivially_copyable<camera>::value, "cameras are sent as raw bytes");
+
+template <class T>
+static void append(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static size_t tile_message_size(image& img, const tile& t) {
+    size_t pixel_count = static_cast<size_t>(t.x1 - t.x0) * (t.y1 - t.y0);
+    return sizeof(farm_tile) + pixel_count * (img.float_planes().size() * sizeof(float) + img.count_planes().size() * sizeof(uint32_t));
+}
+
+static void pack_tile(image& img, const tile& t, int frame_id, std::vector<char>& out) {
+    out.clear();
+    out.reserve(tile_message_size(img, t));
+    append(out, farm_tile{frame_id, t.index});
+    size_t row = t.x1 - t.x0;
+    for (std::vector<float>* plane : img.float_planes())
+        for (int y = t.y0; y < t.y1; ++y) {
+            const char* bytes = reinterpret_cast<const char*>(plane->data() + y * img.width + t.x0);
+            out.insert(out.end(), bytes, bytes + row * sizeof(float));
+        }
+    for (std::vector<uint32_t>* plane : img.count_planes())
+        for (int y = t.y0; y < t.y1; ++y) {
+            const char* bytes = reinterpret_cast<const char*>(plane->data() + y * img.width + t.x0);
+            out.insert(out.end(), bytes, bytes + row * sizeof(uint32_t));
+        }
+}
+
+/* Copies the planes of a tile message (whose size has been checked) over the tile's region of img */
+static void unpack_tile(image& img, const tile& t, const std::vector<char>& in) {
+    const char* bytes = in.data() + sizeof(farm_tile);
+    size_t row = t.x1 - t.x0;
+    for (std::vector<float>* plane : img.float_planes())
+        for (int y = t.y0; y < t.y1; ++y, bytes += row * sizeof(float))
+            memcpy(plane->data() + y * img.width + t.x0, bytes, row * sizeof(float));
+    for (std::vector<uint32_t>* plane : img.count_planes())
+        for (int y = t.y0; y < t.y1; ++y, bytes += row * sizeof(uint32_t))
+            memcpy(plane->data() + y * img.width + t.x0, bytes, row * sizeof(uint32_t));
+}
+
+render_farm::render_farm(const renderer& r, const std::string& scene_data)
+    : worker_timeout(300), settings(r), grid(r.image_width, r.image_height, r.tile_size, 1),
+      next_frame(0), video_frames(0), worker_count(0), stopping(false) {
+    append(setup, r.current_settings());
+    setup.insert(setup.end(), scene_data.begin(), scene_data.end());
+}
+
+render_farm::~render_farm() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stopping = true;
+    }
+    work_added.notify_all();
+    if (acceptor.joinable()) acceptor.join();
+    for (std::thread& s : sessions) s.join();  // each tells its worker to stop
+    socket.close();
+}
+
+bool render_farm::listen(const std::string& address) {
+    if (!socket.listen(address)) return false;
+    std::cout << "Render farm listening on " << address << std::endl;
+    acceptor = std::thread(&render_farm::accept_loop, this);
+    return true;
+}
+
+void render_farm::accept_loop() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (stopping) return;
+        }
+        connection::ptr c = socket.accept(0.2);
+        if (c) sessions.emplace_back(&render_farm::session, this, c);
+    }
+}
+
+bool render_farm::handshake(connection& c, int& threads) {
+    uint32_t type;
+    std::vector<char> payload;
+    farm_hello hello;
+    if (!c.receive(type, payload, std::min(worker_timeout, 10.0)) || type != FARM_HELLO || payload.size() != sizeof(hello))
+        return false;
+    memcpy(&hello, payload.data(), sizeof(hello));
+    if (memcmp(hello.magic, farm_magic, sizeof(farm_magic)) != 0 || hello.version != farm_version) {
+        std::cerr << "Render farm: rejected a connection that is not a compatible worker" << std::endl;
+        return false;
+    }
+    if (hello.real_size != sizeof(real)) {
+        std::cerr << "Render farm: rejected a worker built with " << (hello.real_size == sizeof(float) ? "float" : "double")
+                  << " geometry; it would not render identical tiles" << std::endl;
+        return false;
+    }
+    threads = std::max<int>(hello.threads, 1);
+    return c.send(FARM_SETUP, setup);
+}
+
+/* One thread per connected worker: hands it jobs until the farm stops or the worker fails */
+void render_farm::session(connection::ptr c) {
+    int threads;
+    if (!handshake(*c, threads)) return;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        ++worker_count;
+        std::cout << "\nWorker joined (" << threads << " threads, " << worker_count << " connected)" << std::endl;
+    }
+
+    int frame_id;
+    std::vector<int> tiles;
+    std::vector<char> message, payload;
+    bool failed = false;
+    while (!failed && take_job(threads * 2, frame_id, tiles)) {  // two tiles per thread keeps all threads busy to the end of a job
+        message.clear();
+        append(message, farm_job{frame_id, static_cast<int32_t>(tiles.size())});
+        {
+            std::lock_guard<std::mutex> lock(m);
+            append(message, frames.at(frame_id).cam);
+        }
+        for (int t : tiles) append(message, static_cast<int32_t>(t));
+
+        std::vector<int> owed = tiles;
+        failed = !c->send(FARM_JOB, message);
+        while (!failed && !owed.empty()) {
+            uint32_t type;
+            failed = !c->receive(type, payload, worker_timeout) || type != FARM_TILE || !receive_tile(payload, frame_id, owed);
+        }
+        if (failed) requeue(frame_id, owed);
+    }
+
+    if (!failed) c->send(FARM_STOP, nullptr, 0);
+    c->shutdown();
+    std::lock_guard<std::mutex> lock(m);
+    --worker_count;
+    if (failed)
+        std::cerr << "\nWorker lost; its unfinished tiles go back to the queue (" << worker_count << " still connected)" << std::endl;
+}
+
+/* Waits for queued tiles and claims up to max_tiles of them, all from the oldest frame. Returns false once the farm stops. */
+bool render_farm::take_job(int max_tiles, int& frame_id, std::vector<int>& tiles) {
+    std::unique_lock<std::mutex> lock(m);
+    work_added.wait(lock, [&] { return stopping || !queue.empty(); });
+    if (stopping) return false;
+
+    frame_id = queue.front().frame;
+    tiles.clear();
+    while (!queue.empty() && queue.front().frame == frame_id && static_cast<int>(tiles.size()) < max_tiles) {
+        tiles.push_back(queue.front().tile);
+        queue.pop_front();
+    }
+    return true;
+}
+
+/* Checks a FARM_TILE message against the tiles the worker owes and merges it into its frame */
+bool render_farm::receive_tile(const std::vector<char>& payload, int frame_id, std::vector<int>& owed) {
+    farm_tile header;
+    if (payload.size() < sizeof(header)) return false;
+    memcpy(&header, payload.data(), sizeof(header));
+    auto it = std::find(owed.begin(), owed.end(), header.tile);
+    if (header.frame != frame_id || it == owed.end()) return false;
+
+    image* pixels;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        pixels = frames.at(frame_id).pixels.get();
+    }
+    tile t = grid.tile_at(header.tile);
+    if (payload.size() != tile_message_size(*pixels, t)) return false;
+
+    // Only this session owes the tile, so no other thread writes its pixels, and the frame stays put until it is complete
+    unpack_tile(*pixels, t, payload);
+    pixels->accum.resolve(pixels->pixels, t.x0, t.y0, t.x1, t.y1, settings.exposure, settings.tone_map);
+    owed.erase(it);
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        --frames.at(frame_id).tiles_left;
+    }
+    tile_received.notify_all();
+    return true;
+}
+
+/* Puts tiles a failed worker owed back in front of the queue, so that the frame they belong to finishes first */
+void render_farm::requeue(int frame_id, const std::vector<int>& tiles) {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        for (auto it = tiles.rbegin(); it != tiles.rend(); ++it) queue.push_front({frame_id, *it});
+    }
+    work_added.notify_all();
+}
+
+/* Queues every tile of a new frame seen through cam */
+int render_farm::start_frame(const camera& cam) {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        id = next_frame++;
+        frame& f = frames[id];
+        f.cam = cam;
+        f.pixels = std::make_unique<image>(settings.image_width, settings.image_height);
+        if (settings.records_features()) f.pixels->aov.allocate();
+        f.tiles_left = grid.grid_size();
+        for (int t = 0; t < grid.grid_size(); ++t) queue.push_back({id, t});
+        if (worker_count == 0) std::cout << "Waiting for workers to connect..." << std::endl;
+    }
+    work_added.notify_all();
+    return id;
+}
+
+/* Waits until every tile of a frame is in, reporting progress, and hands over its image */
+std::unique_ptr<image> render_farm::finish_frame(int frame_id, int index, int total_frames) {
+    std::unique_lock<std::mutex> lock(m);
+    frame& f = frames.at(frame_id);
+    render_progress progress = {0.0, 0, grid.grid_size(), index, total_frames};
+    auto interval = std::chrono::duration<double>(settings.progress_interval);
+    for (;;) {
+        bool done = tile_received.wait_for(lock, interval, [&] { return f.tiles_left == 0; });
+        progress.tiles_done = progress.tile_count - f.tiles_left;
+        progress.fraction = progress.tiles_done / (double) progress.tile_count;
+        if (settings.progress_callback) settings.progress_callback(progress);
+        if (done) break;
+    }
+
+    std::unique_ptr<image> pixels = std::move(f.pixels);
+    frames.erase(frame_id);
+    return pixels;
+}
+
+void render_farm::render_to_file(const std::string filename) {
+    std::cout << "Farm render into file '" << filename << "' started." << std::endl;
+    std::cout << "Dimensions: " << settings.image_width << " x " << settings.image_height << std::endl;
+
+    auto start_time = Time::now();
+    std::unique_ptr<image> pixels = finish_frame(start_frame(settings.cam), 0, 1);
+    print_render_time(Time::now() - start_time, std::cout, 3);
+
+    settings.save_render(filename, *pixels);
+    std::cout << std::endl;
+}
+
+void render_farm::render_frames(const std::vector<camera>& path) {
+    int total_frames = static_cast<int>(path.size());
+    std::cout << "Farm video render of " << total_frames << " frames started." << std::endl;
+    std::cout << "Dimensions: " << settings.image_width << " x " << settings.image_height << std::endl;
+
+    async_image_writer writer;
+    auto start_time = Time::now();
+
+    // Frame N+1 is queued before frame N is finished, so workers render on while frame N is denoised and written
+    std::deque<int> in_flight;
+    auto finish = [&](int index) {
+        std::unique_ptr<image> pixels = finish_frame(in_flight.front(), index, total_frames);
+        in_flight.pop_front();
+        if (settings.denoise) settings.denoise_image(*pixels);
+        writer.submit("output/" + std::to_string(video_frames + index) + ".ppm", pixels.release());
+    };
+    for (int curr_frame = 0; curr_frame < total_frames; ++curr_frame) {
+        in_flight.push_back(start_frame(path[curr_frame]));
+        if (in_flight.size() == 2) finish(curr_frame - 1);
+    }
+    if (!in_flight.empty()) finish(total_frames - 1);
+    writer.wait();
+    video_frames += total_frames;
+
+    duration render_time = Time::now() - start_time;
+    print_render_time(render_time, std::cout, 3);
+    std::cout << "Average per frame: " << render_time.count() / std::max(total_frames, 1) << "s" << std::endl << std::endl;
+}
+
+bool run_render_worker(const std::string& address, int threads) {
+    connection::ptr c = connection::connect(address);
+    if (!c) return false;
+
+    renderer r;
+    r.core_count = threads > 0 ? threads : std::max<int>(std::thread::hardware_concurrency(), 1);
+    farm_hello hello = {};
+    memcpy(hello.magic, farm_magic, sizeof(farm_magic));
+    hello.version = farm_version;
+    hello.real_size = sizeof(real);
+    hello.threads = r.core_count;
+
+    uint32_t type;
+    std::vector<char> payload;
+    render_settings s;
+    bool setup = c->send(FARM_HELLO, &hello, sizeof(hello)) && c->receive(type, payload) && type == FARM_SETUP && payload.size() >= sizeof(s);
+    if (setup) memcpy(&s, payload.data(), sizeof(s));
+    // The settings size the image and the tile grid below, so a corrupt setup counts as none
+    const int32_t max_size = 1 << 16;
+    if (!setup || s.image_width <= 0 || s.image_width > max_size || s.image_height <= 0 || s.image_height > max_size ||
+        s.tile_size <= 0 || s.samples_per_pixel <= 0) {
+        std::cerr << "Render worker: no setup from the coordinator at " << address << std::endl;
+        return false;
+    }
+
+    scene_description scene;
+    if (!parse_scene(payload.data() + sizeof(s), payload.size() - sizeof(s), scene, "coordinator's scene")) return false;
+    r.world = scene.world;
+    r.build_bvh();
+    r.apply_settings(s);
+    std::cout << "Render worker connected to " << address << ": " << r.image_width << " x " << r.image_height << ", "
+              << r.samples_per_pixel << " spp, " << r.core_count << " threads" << std::endl;
+
+    image pixels(r.image_width, r.image_height);  // tiles of any frame; render_tiles() clears each before rendering it
+    if (s.features) pixels.aov.allocate();
+    const int grid_size = tile_scheduler(r.image_width, r.image_height, r.tile_size, 1).grid_size();
+    std::vector<char> in_job(grid_size);
+    std::vector<int> tiles;
+    std::vector<char> message;
+    int jobs = 0;
+    for (;;) {
+        if (!c->receive(type, payload)) {
+            std::cerr << "Render worker: lost the coordinator after " << jobs << " jobs" << std::endl;
+            return false;
+        }
+        if (type == FARM_STOP) break;
+
+        farm_job job;
+        if (type != FARM_JOB || payload.size() < sizeof(job) + sizeof(camera)) return false;
+        memcpy(&job, payload.data(), sizeof(job));
+        if (job.tile_count < 0 || job.tile_count > grid_size ||
+            payload.size() != sizeof(job) + sizeof(camera) + job.tile_count * sizeof(int32_t)) return false;
+        memcpy(&r.cam, payload.data() + sizeof(job), sizeof(camera));
+        tiles.resize(job.tile_count);
+        std::fill(in_job.begin(), in_job.end(), 0);
+        for (int i = 0; i < job.tile_count; ++i) {
+            int32_t t;
+            memcpy(&t, payload.data() + sizeof(job) + sizeof(camera) + i * sizeof(int32_t), sizeof(t));
+            // Each tile at most once and inside the grid, or the render threads would write outside pixels or race on it
+            if (t < 0 || t >= grid_size || in_job[t]) {
+                std::cerr << "Render worker: bad tile " << t << " in job (" << grid_size << " tiles in the grid); dropping the connection" << std::endl;
+                return false;
+            }
+            in_job[t] = 1;
+            tiles[i] = t;
+        }
+
+        bool sent = true;
+        r.render_tiles(pixels, tiles, [&](const tile& t) {
+            pack_tile(pixels, t, job.frame, message);
+            sent = sent && c->send(FARM_TILE, message);
+        });
+        if (!sent) {
+            std::cerr << "Render worker: lost the coordinator after " << jobs << " jobs" << std::endl;
+            return false;
+        }
+        ++jobs;
+    }
+    std::cout << "Render worker finished after " << jobs << " jobs" << std::endl;
+    return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+#include "../renderer.h"
+#include "../../scene/scene_file.h"
+#include "../../network/connection/connection.h"
+
+/*
+  Distributed rendering: a coordinator hands out tiles of each frame to worker processes on other machines (or the same
+  one), which stream the finished tiles back as raw accumulation data.
+
+  A worker (run_render_worker()) connects to the coordinator and says hello with its thread count and build (the size of
+  'real' must match). The coordinator answers with the render settings and the bytes of the scene file, so workers need
+  nothing but the address. After that it sends jobs: a frame number, that frame's camera and a list of tile indices in
+  the renderer's tile_size grid. The worker renders the tiles with renderer::render_tiles() and sends each one back as it
+  completes: radiance sums, sample counts and the denoiser's feature sums, as floats. Tiles come out of a worker exactly
+  as they would out of a local render, since every pixel's samples depend only on the seed and the pixel, so the merged
+  image is identical to a single-process render.
+
+  A worker that disconnects, or sends nothing for worker_timeout seconds, is dropped and the tiles it still owed are put
+  back at the front of the queue for the others. Workers may join at any time, including in the middle of a frame.
+  Up to two frames are in flight at once, so workers keep busy while the coordinator denoises & writes the previous one.
+
+  Messages are framed by connection: a type and a payload of the structs below, in the byte order of the machines (farms
+  are assumed to be all little-endian).
+*/
+enum farm_message : uint32_t { FARM_HELLO = 1, FARM_SETUP = 2, FARM_JOB = 3, FARM_TILE = 4, FARM_STOP = 5 };
+
+struct farm_hello {
+  char magic[8];        // "RTWFARM1"
+  uint32_t version;
+  uint32_t real_size;   // sizeof(real): workers must be the same build as the coordinator for identical results
+  int32_t threads;      // worker threads rendering jobs; the coordinator sizes their jobs by it
+};
+
+/* Payload of FARM_SETUP is the coordinator's render_settings, followed by the scene file (text or binary form) */
+
+/* Payload of FARM_JOB, followed by the camera and tile_count int32 tile indices */
+struct farm_job {
+  int32_t frame;
+  int32_t tile_count;
+};
+
+/* Payload of FARM_TILE, followed by the tile's rows of each accum & aov float plane, then of their sample counts */
+struct farm_tile {
+  int32_t frame;
+  int32_t tile;
+};
+
+class render_farm {
+  public:
+    // Renders scene_data (the contents of a scene file) with settings' render settings, camera & output options
+    render_farm(const renderer& settings, const std::string& scene_data);
+    ~render_farm();
+
+    bool listen(const std::string& address);  // starts accepting workers
+    void render_to_file(const std::string filename);
+    void render_frames(const std::vector<camera>& path);  // video frames into output/<N>.ppm, like renderer::render_frames
+
+  public:
+    double worker_timeout;  // seconds a worker may stay silent while it owes tiles before it is dropped
+
+  private:
+    struct frame {
+      camera cam;
+      std::unique_ptr<image> pixels;
+      int tiles_left;
+    };
+
+    struct pending_tile {
+      int frame;
+      int tile;
+    };
+
+    void accept_loop();
+    void session(connection::ptr c);
+    bool handshake(connection& c, int& threads);
+    bool take_job(int max_tiles, int& frame_id, std::vector<int>& tiles);
+    bool receive_tile(const std::vector<char>& payload, int frame_id, std::vector<int>& owed);
+    void requeue(int frame_id, const std::vector<int>& tiles);
+    int start_frame(const camera& cam);
+    std::unique_ptr<image> finish_frame(int frame_id, int index, int total_frames);
+
+  private:
+    const renderer& settings;
+    std::vector<char> setup;  // FARM_SETUP payload
+    tile_scheduler grid;      // geometry of the tile grid (tile_at())
+    listener socket;
+    std::thread acceptor;
+    std::vector<std::thread> sessions;
+
+    std::mutex m;
+    std::condition_variable work_added;     // queue grew, or stopping
+    std::condition_variable tile_received;
+    std::map<int, frame> frames;            // frames in flight, by id
+    std::deque<pending_tile> queue;         // tiles no worker has claimed
+    int next_frame;
+    int video_frames;  // written so far, to number output/<N>.ppm
+    int worker_count;
+    bool stopping;
+};
+
+/* Serves a coordinator at address until it sends FARM_STOP (returns true) or the connection fails. threads <= 0 uses every hardware thread. */
+bool run_render_worker(const std::string& address, int threads);
@@ -1,82 +1,691 @@
 #include "renderer.h"
+#include "render_checkpoint/render_checkpoint.h"
+
+#include <algorithm>
+#include <typeinfo>
 
 using namespace std::chrono_literals;
 
+/* Sample dimensions (see sampler.h) each decision draws from with sampling = SOBOL, so that decision is stratified
+   across a pixel's samples: the pixel jitter and lens position come first, then every bounce gets DIMS_PER_BOUNCE
+   dimensions for its light sample (pick and cone), scattering and the roulette roll */
+enum : uint32_t {
+    DIM_PIXEL = 0, DIM_LENS = 2, DIM_FIRST_BOUNCE = 4,
+    DIM_LIGHT = 0, DIM_SCATTER = 4, DIM_ROULETTE = 7, DIMS_PER_BOUNCE = 8
+};
+
+static void start_bounce_dimension(int bounce, uint32_t offset) {
+    start_sample_dimension(DIM_FIRST_BOUNCE + DIMS_PER_BOUNCE*bounce + offset);
+}
+
+// Path statistics of this thread since its last flush into the renderer's totals (see st_render_to_mem)
+static thread_local path_stats local_paths;
+
 renderer::renderer() {
 	frame_count = 0;
+	tile_size = 32;
+	seed = 0;
+	sampling = sample_pattern::SOBOL;
+	adaptive_sampling = false;
+	min_samples_per_pixel = 16;
+	adaptive_threshold = 0.05;
+	write_spp_heatmap = false;
+	write_aovs = false;
+	denoise = false;
+	progress_callback = print_progress;
+	progress_interval = 0.1;
+	exposure = 1.0;
+	tone_map = tone_mapping::NONE;
+	max_fps = 60;
+	preview_downscale = 4;
+	roulette_depth = 3;
+	roulette_threshold = 0.5;
+	wavefront = false;
+	wavefront_batch = 4096;
+	background = color(1,1,1);
+	next_event_estimation = true;
+	checkpoint_interval = 60;
+	resume = false;
+	scene_hash = 0;
+}
+
+/* Builds a BVH over the objects currently in world and uses it as the root for all subsequent renders, and rebuilds the
+   light list. Must be called again if world is modified afterwards. */
+void renderer::build_bvh() {
+    world_root = bvh_node::build(world);
+    build_lights();
+}
+
+/* Collects the emissive spheres of world for light sampling. Called by build_bvh(); must be called again if world is modified. */
+void renderer::build_lights() {
+    lights = light_list(world);
+}
+
+/* The options a render depends on, for a render farm worker or a checkpoint file to reproduce it exactly */
+render_settings renderer::current_settings() const {
+    render_settings s = {};
+    s.image_width = image_width;
+    s.image_height = image_height;
+    s.samples_per_pixel = samples_per_pixel;
+    s.min_samples_per_pixel = min_samples_per_pixel;
+    s.bounce_depth = bounce_depth;
+    s.roulette_depth = roulette_depth;
+    s.tile_size = tile_size;
+    s.wavefront_batch = wavefront_batch;
+    s.adaptive_sampling = adaptive_sampling;
+    s.next_event_estimation = next_event_estimation;
+    s.wavefront = wavefront;
+    s.sampling = static_cast<int32_t>(sampling);
+    s.adaptive_threshold = adaptive_threshold;
+    s.roulette_threshold = roulette_threshold;
+    for (int c = 0; c < 3; ++c) s.background[c] = background[c];
+    s.features = records_features();
+    s.seed = seed;
+    return s;
+}
+
+/* Takes over a render farm coordinator's current_settings(). Everything but features, which is up to the images rendered into. */
+void renderer::apply_settings(const render_settings& s) {
+    image_width = s.image_width;
+    image_height = s.image_height;
+    samples_per_pixel = s.samples_per_pixel;
+    min_samples_per_pixel = s.min_samples_per_pixel;
+    bounce_depth = s.bounce_depth;
+    roulette_depth = s.roulette_depth;
+    tile_size = s.tile_size;
+    wavefront_batch = s.wavefront_batch;
+    adaptive_sampling = s.adaptive_sampling != 0;
+    next_event_estimation = s.next_event_estimation != 0;
+    wavefront = s.wavefront != 0;
+    sampling = static_cast<sample_pattern>(s.sampling);
+    adaptive_threshold = s.adaptive_threshold;
+    roulette_threshold = s.roulette_threshold;
+    background = color(s.background[0], s.background[1], s.background[2]);
+    seed = s.seed;
+}
+
+/* Whether renders record the denoiser's features: into images whose aov buffer is allocated, which pool_render() and
+   the window do when this is on */
+bool renderer::records_features() const {
+    return denoise || write_aovs;
+}
+
+/* Makes primary rays get traced in packets of ray_packet::size against an SoA copy of world. Only possible when world
+   consists solely of spheres; returns false (and leaves packet tracing off) otherwise. Must be called again if world is modified.
+   The packets bypass world_root: every packet is tested against every sphere, so primary rays cost O(spheres) instead of
+   the BVH's logarithmic time. Only worth it for small sphere-only scenes (a few hundred spheres at most). */
+bool renderer::enable_packet_tracing() {
+    packet_scene = std::make_shared<sphere_soa>(world);
+    if (!packet_scene->complete()) {
+        std::cout << "Packet tracing needs a world made only of spheres; falling back to single rays." << std::endl;
+        packet_scene.reset();
+        return false;
+    }
+    return true;
+}
+
+void path_stats::count(std::vector<uint64_t>& counter, int bounce, uint64_t n) {
+    if (counter.size() <= (size_t) bounce) counter.resize(bounce + 1, 0);
+    counter[bounce] += n;
+}
+
+void path_stats::add(const path_stats& other) {
+    for (size_t b = 0; b < other.rays.size(); ++b) count(rays, b, other.rays[b]);
+    for (size_t b = 0; b < other.escaped.size(); ++b) count(escaped, b, other.escaped[b]);
+    for (size_t b = 0; b < other.roulette.size(); ++b) count(roulette, b, other.roulette[b]);
+    depth_limited += other.depth_limited;
+    shadow_rays += other.shadow_rays;
+}
+
+void path_stats::clear() {
+    rays.clear();
+    escaped.clear();
+    roulette.clear();
+    depth_limited = 0;
+    shadow_rays = 0;
+}
+
+ray_stats renderer::ray_counts() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ray_stats totals = {0, 0, path_totals.shadow_rays};
+    for (size_t b = 0; b < path_totals.rays.size(); ++b)
+        (b == 0 ? totals.primary : totals.secondary) += path_totals.rays[b];
+    return totals;
+}
+
+path_stats renderer::path_counts() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return path_totals;
 }
 
-/* Takes in a ray and bounce depth and returns RGB color of the object that was hit */
-pixel renderer::ray_color(const ray& r, int depth) const {
-    // If bounce depth has been reached, return black color
-    if (depth < 0) return color(0,0,0);
+void renderer::reset_ray_counts() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    path_totals.clear();
+}
 
+const hittable& renderer::scene_root() const {
+    if (world_root) return *world_root;
+    return world;
+}
+
+/* Follows the path starting with ray r through at most depth more bounces and returns the light it carries back.
+   Iterative: the product of albedos along the path so far (throughput) is carried forward instead of recursing. Once
+   throughput drops below roulette_threshold (after roulette_depth bounces), the path survives with probability
+   throughput/roulette_threshold and is reweighted by the inverse, which keeps the estimate unbiased while cutting
+   short paths that could add little. first_hit, if given, is r's already known first intersection (packet tracing).
+   With next_event_estimation on, every diffuse hit also samples a light directly (see sample_light()); light the path
+   then finds by scattering into an emitter is MIS-weighted against that (see emission_weight()). If features is given,
+   the path's denoiser features are recorded in it (see record_features()). */
+pixel renderer::ray_color(ray r, int depth, const hit_record* first_hit, aov_sample* features) const {
+    color radiance(0,0,0);
+    color throughput(1,1,1);
     hit_record rec;
-    ray reflected_ray;
+    path_vertex prev = {point3(), 0.0, true};  // the camera counts as specular: emitters it sees directly get full weight
+    bool recording = features != nullptr;
+
+    for (int bounce = 0; bounce <= depth; ++bounce) {
+        bool hit;
+        if (bounce == 0 && first_hit != nullptr) {
+            rec = *first_hit;
+            hit = true;
+        } else {
+            local_paths.count(local_paths.rays, bounce);
+            hit = scene_root().hit(r, 0.001, infinity, rec);
+        }
+
+        if (recording) recording = !record_features(*features, r, hit ? &rec : nullptr, throughput, bounce);
+
+        if (!hit) {
+            local_paths.count(local_paths.escaped, bounce);
+            return radiance + throughput * miss_color(r);
+        }
+
+        // Emitters end the path
+        const material* m = rec.material_ptr;
+        color emitted = m->emitted();
+        if (emitted.x() > 0 || emitted.y() > 0 || emitted.z() > 0)
+            return radiance + throughput * emitted * emission_weight(prev, rec);
+
+        // Direct light
+        ray shadow;
+        double shadow_t;
+        color direct;
+        start_bounce_dimension(bounce, DIM_LIGHT);
+        if (sample_light(rec, shadow, shadow_t, direct) && unoccluded(shadow, shadow_t))
+            radiance += throughput * direct;
+
+        // Scatter off the material and keep tracing
+        start_bounce_dimension(bounce, DIM_SCATTER);
+        ray scattered = m->scatter(r, rec);
+        prev = {rec.p, m->is_diffuse() ? m->pdf(rec, scattered.direction()) : 0.0, !m->is_diffuse()};
+        throughput = throughput * m->albedo;
+        r = scattered;
+
+        start_bounce_dimension(bounce, DIM_ROULETTE);
+        if (!survives_roulette(throughput, bounce)) return radiance;
+    }
+
+    // If bounce depth has been reached, the path adds nothing more
+    ++local_paths.depth_limited;
+    return radiance;
+}
+
+/* Power heuristic MIS weight for a sample drawn with density pdf_a, when pdf_b is the density the other strategy has for it */
+static double power_heuristic(double pdf_a, double pdf_b) {
+    double a2 = pdf_a*pdf_a, b2 = pdf_b*pdf_b;
+    return a2 / (a2 + b2);
+}
+
+/* MIS weight of emitted light at rec, reached by scattering from prev. Full weight unless light sampling could have
+   produced the same direction, i.e. unless prev is a diffuse surface and next-event estimation is on. */
+double renderer::emission_weight(const path_vertex& prev, const hit_record& rec) const {
+    if (prev.specular || !next_event_estimation || lights.empty()) return 1.0;
+    return power_heuristic(prev.pdf, lights.pdf(prev.p, rec.p, rec.material_ptr));
+}
+
+/* Next-event estimation at a diffuse hit: picks a point on a light and returns the shadow ray (and the distance up to
+   which it must be unoccluded) together with the MIS-weighted light it brings in if it is. False if there is nothing to add. */
+bool renderer::sample_light(const hit_record& rec, ray& shadow, double& t_max, color& contribution) const {
+    const material* m = rec.material_ptr;
+    if (!next_event_estimation || lights.empty() || !m->is_diffuse()) return false;
+
+    light_sample ls;
+    if (!lights.sample(rec.p, ls)) return false;
+    color f = m->eval(rec, ls.direction);
+    if (f.x() <= 0 && f.y() <= 0 && f.z() <= 0) return false;  // light is behind the surface
+
+    shadow = ray(rec.p, ls.direction);
+    t_max = ls.distance * (1.0 - 1e-6);  // stop short of the light's own surface
+    contribution = f * ls.radiance * (power_heuristic(ls.pdf, m->pdf(rec, ls.direction)) / ls.pdf);
+    return true;
+}
+
+/* Visibility test for shadow rays: an any-hit query, which can stop at the first blocker instead of finding the closest */
+bool renderer::unoccluded(const ray& shadow, double t_max) const {
+    ++local_paths.shadow_rays;
+    return !scene_root().occluded(shadow, 0.001, t_max);
+}
 
-    if (world.hit(r, 0.001, DBL_MAX, rec)) {
-        reflected_ray = rec.material_ptr->scatter(r, rec);
-        return rec.material_ptr->albedo * ray_color(reflected_ray, depth-1);
+/* Russian roulette after bounce: false if the path should end here, otherwise reweights throughput if it had to survive a roll */
+bool renderer::survives_roulette(color& throughput, int bounce) const {
+    if (bounce < roulette_depth) return true;
+    double survival = std::max(throughput.x(), std::max(throughput.y(), throughput.z())) / roulette_threshold;
+    if (survival >= 1.0) return true;
+    if (random_double() >= survival) {
+        local_paths.count(local_paths.roulette, bounce);
+        return false;
     }
-    return pixel(1,1,1);
+    throughput = throughput / survival;
+    return true;
 }
 
-/* Single-threaded render to memory location passed in. Adds final pixel divided by core count to each output pixel. */
-void renderer::st_render_to_mem(image* const pixels, a_int& scanlines, a_bool* KILL) const {
+pixel renderer::miss_color(const ray&) const {
+    return background;
+}
+
+/* Denoiser features of a path, recorded bounce by bounce until it returns true: the camera distance of the first hit,
+   and the albedo & normal where the path first meets a diffuse surface, an emitter or the background. Mirror and glass
+   hits are looked through (their albedo is carried in throughput), so the denoiser sees the edges of what they show.
+   rec is null if the ray missed. */
+bool renderer::record_features(aov_sample& f, const ray& r, const hit_record* rec, const color& throughput, int bounce) const {
+    if (bounce == 0) f.depth = rec != nullptr ? rec->t * r.direction().length() : 0.0;
+    if (rec == nullptr) {
+        f.albedo = throughput;
+        f.normal = vec3(0,0,0);
+        return true;
+    }
+    const material* m = rec->material_ptr;
+    color emitted = m->emitted();
+    bool emitter = emitted.x() > 0 || emitted.y() > 0 || emitted.z() > 0;
+    f.albedo = emitter ? throughput : throughput * m->albedo;
+    f.normal = rec->normal;
+    return emitter || m->is_diffuse();
+}
+
+/* Adds sample color c, whose first-hit features are f, to the feature sums of its pixel */
+static void add_features(aov_sample& sum, aov_sample f, const color& c) {
+    f.lum = luminance(c) / std::max(luminance(f.albedo), 0.01);
+    f.lum2 = f.lum * f.lum;
+    sum += f;
+}
+
+/* With sampling = SOBOL, points the thread's random numbers at sample number 'sample' of the pixel with the given
+   index: the same pixel seed as RANDOM sampling, but it now picks the scrambling of the pixel's Sobol sequence, so
+   neighbouring pixels get decorrelated point sets. Numbering samples by the pixel's running total makes successive passes
+   continue the sequence. With RANDOM sampling the pixel's PCG32 stream just carries on. */
+void renderer::start_sample(int index, int sample) const {
+    if (sampling == sample_pattern::SOBOL)
+        start_sample_sequence(hash64(seed ^ hash64(index)), sample);
+}
+
+/* Camera ray through a random point inside pixel (j, i) of a width x height image */
+ray renderer::camera_ray(int j, int i, int width, int height) const {
+    double du, dv;
+    random_pair(du, dv);  // DIM_PIXEL; the lens sample in get_ray() takes DIM_LENS
+    return cam.get_ray((j+du) / width, (i+dv) / height);
+}
+
+/* Traces 'count' (at most ray_packet::size) samples, numbered from first_sample, through pixel (j, i) of a width x height
+   image and writes their colors into samples and, unless features is null, their first-hit features into features */
+void renderer::trace_samples(int j, int i, int width, int height, int first_sample, int count, color* samples, aov_sample* features) const {
+    const int index = i*width + j;
+    if (!packet_scene) {
+        for (int k = 0; k < count; ++k) {
+            start_sample(index, first_sample + k);
+            samples[k] = ray_color(camera_ray(j, i, width, height), bounce_depth, nullptr, features ? &features[k] : nullptr);
+        }
+        return;
+    }
+
+    // Primary rays through the same pixel are coherent: find their first hits together, then follow each path on its own
+    ray rays[ray_packet::size];
+    ray_packet rp;
+    for (int k = 0; k < count; ++k) {
+        start_sample(index, first_sample + k);
+        rays[k] = camera_ray(j, i, width, height);
+    }
+    for (int k = 0; k < ray_packet::size; ++k)
+        rp.set(k, rays[k < count ? k : 0]);  // pad a partial packet with copies of the first ray
+
+    packet_hit ph;
+    packet_scene->hit_packet(rp, 0.001, infinity, ph);
+    local_paths.count(local_paths.rays, 0, count);
+
+    for (int k = 0; k < count; ++k) {
+        if (ph.index[k] < 0) {
+            samples[k] = miss_color(rays[k]);
+            if (features) record_features(features[k], rays[k], nullptr, color(1,1,1), 0);
+            continue;
+        }
+        hit_record rec;
+        packet_scene->finalize_hit(rays[k], ph.index[k], ph.t[k], rec);
+        start_sample(index, first_sample + k);
+        samples[k] = ray_color(rays[k], bounce_depth, &rec, features ? &features[k] : nullptr);
+    }
+}
+
+/* Adaptive sampling stop test: true once the 95% confidence interval of the pixel's mean luminance is within
+   adaptive_threshold of the mean (relative error, with a floor so near-black pixels don't sample forever) */
+bool renderer::pixel_converged(int n, double mean, double m2) const {
+    if (n < 2) return false;
+    double variance = m2 / (n - 1);
+    double ci = 1.96 * std::sqrt(variance / n);
+    return ci <= adaptive_threshold * std::max(mean, 0.01);
+}
 
-    // Split the render across all cores
-    int divided_spp = samples_per_pixel/core_count;
+/* Renders every pixel of the tile, adds the samples to the image's accumulation buffer and resolves the tile for display.
+   Pixels take spp samples, or with adaptive sampling on, anywhere between min_samples_per_pixel and spp depending on how
+   quickly they converge. */
+void renderer::render_tile(image* const pixels, const tile& t, int spp, a_bool* KILL) const {
+    const int width = pixels->width, height = pixels->height;
+    const bool recording = pixels->aov.allocated();  // denoiser features are only kept if the image has room for them
+    for (int i = t.y0; i < t.y1; ++i) {
+        for (int j = t.x0; j < t.x1; ++j) {
+            if (KILL != nullptr) if (*KILL == true) return;
+            // Seeded per pixel and per pass (by the samples already accumulated), so output doesn't depend on which thread renders it
+            int index = i*width + j;
+            int first_sample = pixels->accum.samples(index);
+            if (sampling == sample_pattern::RANDOM) seed_random(hash64(seed ^ hash64(index)), first_sample);
 
-    for (int i = 0; i < image_height; ++i) {
-        for (int j = 0; j < image_width; ++j) {
-            if (KILL != nullptr) if (*KILL == true) goto done;
             color sum;
-            for (int k = 0; k < divided_spp; ++k) {
-                double u = (j+random_double()) / image_width;
-                double v = (i+random_double()) / image_height;
-                ray r = cam.get_ray(u, v);
-                sum += ray_color(r, bounce_depth);
+            color batch[ray_packet::size];
+            aov_sample feature_sum;
+            aov_sample batch_features[ray_packet::size];
+            int n = 0;
+            double mean = 0.0, m2 = 0.0;  // running luminance mean & sum of squared deviations (Welford)
+
+            while (n < spp) {
+                int count = std::min(ray_packet::size, spp - n);
+                trace_samples(j, i, width, height, first_sample + n, count, batch, recording ? batch_features : nullptr);
+                for (int b = 0; b < count; ++b) {
+                    sum += batch[b];
+                    if (recording) add_features(feature_sum, batch_features[b], batch[b]);
+                    ++n;
+                    double y = luminance(batch[b]);
+                    double delta = y - mean;
+                    mean += delta / n;
+                    m2 += delta * (y - mean);
+                }
+                if (adaptive_sampling && n >= min_samples_per_pixel && pixel_converged(n, mean, m2)) break;
             }
-            pixel final = sqrt(sum/divided_spp);   // sqrt for gamma correction
-            pixel partial_avg = final / core_count;
-            (*pixels)(j,i) += convert_to_ARGB8888(partial_avg);
+
+            pixels->accum.add(j, i, sum, n);
+            if (recording) pixels->aov.add(j, i, feature_sum, n);
         }
-        ++scanlines;
     }
-    done: {};
+    pixels->accum.resolve(pixels->pixels, t.x0, t.y0, t.x1, t.y1, exposure, tone_map);
 }
 
-/* Multi-threaded render to memory location passed in */
-void renderer::mt_render_to_mem(image* const pixels, a_bool* RENDER_DONE, a_bool* KILL) const {
+/*
+=======================================
+    Wavefront path tracing
+=======================================
+*/
+
+/* One in-flight path of a wavefront batch */
+struct wavefront_path {
+    ray r;
+    color throughput;
+    path_vertex prev;
+    int pixel;   // index within the tile
+    int sample;  // sample number within the pixel, counting previous passes
+    int bounce;
+    color radiance;       // gathered so far; added to the pixel when the path ends
+    aov_sample features;  // for the denoiser, see record_features()
+    bool recording;       // features still to be completed
+};
+
+/* Shadow ray queued by a wavefront round; contribution is added to pixel if it is unoccluded up to t_max */
+struct wavefront_shadow {
+    ray r;
+    double t_max;
+    color contribution;
+    int path;  // index in the batch
+};
+
+/* Breadth-first version of render_tile: the tile's spp*pixels paths are traced in batches of up to wavefront_batch paths.
+   Every round intersects the whole batch, queues the hits by material type and scatters each queue in one tight loop
+   (so the same material code and data stay hot), queueing light samples as shadow rays that are traced together at the
+   end of the round. Finished paths then add their light and first-hit features to their pixels and are compacted out,
+   and the batch is topped back up with new camera rays. Ignores adaptive sampling and packet tracing. With RANDOM
+   sampling, random numbers are drawn in batch order from one stream per tile and pass, so output is still independent
+   of which thread renders the tile, but differs from render_tile's. With SOBOL sampling every path draws from its own
+   sample's sequence, so the image matches render_tile's. */
+void renderer::render_tile_wavefront(image* const pixels, const tile& t, int spp, a_bool* KILL) const {
+    const int width = pixels->width, height = pixels->height;
+    const int tile_width = t.x1 - t.x0;
+    const int tile_pixels = tile_width * (t.y1 - t.y0);
+    const long total_paths = (long) tile_pixels * spp;
+    const int batch_size = std::max(wavefront_batch, 1);
+    const bool recording = pixels->aov.allocated();
 
-    // create an array of threads
-    std::thread threads[core_count];
+    int first = t.y0*width + t.x0;
+    if (sampling == sample_pattern::RANDOM)
+        seed_random(hash64(seed ^ hash64(first) ^ 0x5741564546524f4eULL), pixels->accum.samples(first));
 
-    // stores (# of scanlines completed * core_count); thus, divide by core_count to get # of scanlines done rendering
-    a_int scanlines = 0;
+    std::vector<color> sums(tile_pixels);
+    std::vector<aov_sample> feature_sums(recording ? tile_pixels : 0);
+    std::vector<wavefront_path> paths;
+    std::vector<hit_record> hits;
+    std::vector<std::pair<const std::type_info*, std::vector<int>>> queues;  // path indices per material type
+    std::vector<wavefront_shadow> shadows;
+    paths.reserve(batch_size);
+    hits.resize(batch_size);
 
-    // launch as many threads as CPU cores, rendering one image on each thread
-    for (int i = 0; i < core_count; ++i)
-        threads[i] = std::thread(&renderer::st_render_to_mem, this, pixels, std::ref(scanlines), KILL);
+    long next_path = 0;
+    while (next_path < total_paths || !paths.empty()) {
+        if (KILL != nullptr) if (*KILL == true) return;
+
+        // Regenerate: top the batch up with camera rays
+        int fresh = 0;
+        while ((int) paths.size() < batch_size && next_path < total_paths) {
+            int p = next_path / spp;
+            int j = t.x0 + p % tile_width, i = t.y0 + p / tile_width;
+            int sample = pixels->accum.samples(i*width + j) + next_path++ % spp;
+            start_sample(i*width + j, sample);
+            paths.push_back({camera_ray(j, i, width, height), color(1,1,1), {point3(), 0.0, true}, p, sample, 0, color(0,0,0), aov_sample(), recording});
+            ++fresh;
+        }
+        local_paths.count(local_paths.rays, 0, fresh);
+
+        // Intersect the whole batch; misses finish here, hits are queued by material type
+        for (auto& q : queues) q.second.clear();
+        for (int k = 0; k < (int) paths.size(); ++k) {
+            wavefront_path& path = paths[k];
+            if (path.bounce > 0) local_paths.count(local_paths.rays, path.bounce);
+            bool hit = scene_root().hit(path.r, 0.001, infinity, hits[k]);
+            if (path.recording) path.recording = !record_features(path.features, path.r, hit ? &hits[k] : nullptr, path.throughput, path.bounce);
+            if (!hit) {
+                local_paths.count(local_paths.escaped, path.bounce);
+                path.radiance += path.throughput * miss_color(path.r);
+                path.bounce = -1;  // finished
+                continue;
+            }
+            color emitted = hits[k].material_ptr->emitted();
+            if (emitted.x() > 0 || emitted.y() > 0 || emitted.z() > 0) {
+                path.radiance += path.throughput * emitted * emission_weight(path.prev, hits[k]);
+                path.bounce = -1;
+                continue;
+            }
+            const std::type_info* type = &typeid(*hits[k].material_ptr);
+            size_t q = 0;
+            while (q < queues.size() && queues[q].first != type) ++q;
+            if (q == queues.size()) queues.push_back({type, {}});
+            queues[q].second.push_back(k);
+        }
+
+        // Shade one material type at a time
+        shadows.clear();
+        for (auto& q : queues) {
+            for (int k : q.second) {
+                wavefront_path& path = paths[k];
+                const material* m = hits[k].material_ptr;
+                start_sample(t.y0*width + t.x0 + (path.pixel / tile_width)*width + path.pixel % tile_width, path.sample);
+                wavefront_shadow sh;
+                start_bounce_dimension(path.bounce, DIM_LIGHT);
+                if (sample_light(hits[k], sh.r, sh.t_max, sh.contribution)) {
+                    sh.contribution = path.throughput * sh.contribution;
+                    sh.path = k;
+                    shadows.push_back(sh);
+                }
+                start_bounce_dimension(path.bounce, DIM_SCATTER);
+                ray scattered = m->scatter(path.r, hits[k]);
+                path.prev = {hits[k].p, m->is_diffuse() ? m->pdf(hits[k], scattered.direction()) : 0.0, !m->is_diffuse()};
+                path.throughput = path.throughput * m->albedo;
+                path.r = scattered;
+                start_bounce_dimension(path.bounce, DIM_ROULETTE);
+                if (!survives_roulette(path.throughput, path.bounce))
+                    path.bounce = -1;
+                else if (++path.bounce > bounce_depth) {
+                    ++local_paths.depth_limited;
+                    path.bounce = -1;
+                }
+            }
+        }
+
+        for (const wavefront_shadow& sh : shadows)
+            if (unoccluded(sh.r, sh.t_max)) paths[sh.path].radiance += sh.contribution;
+
+        // Compact: hand finished paths to their pixels and keep the ones that are still going, in order
+        for (const wavefront_path& path : paths)
+            if (path.bounce < 0) {
+                sums[path.pixel] += path.radiance;
+                if (recording) add_features(feature_sums[path.pixel], path.features, path.radiance);
+            }
+        paths.erase(std::remove_if(paths.begin(), paths.end(), [](const wavefront_path& path) { return path.bounce < 0; }), paths.end());
+    }
+
+    for (int p = 0; p < tile_pixels; ++p) {
+        pixels->accum.add(t.x0 + p % tile_width, t.y0 + p / tile_width, sums[p], spp);
+        if (recording) pixels->aov.add(t.x0 + p % tile_width, t.y0 + p / tile_width, feature_sums[p], spp);
+    }
+    pixels->accum.resolve(pixels->pixels, t.x0, t.y0, t.x1, t.y1, exposure, tone_map);
+}
 
-    // Print out rendering progress as a percentage
-    while((scanlines/core_count) != image_height) {
-        if (KILL != nullptr) if (*KILL) break; // Stop printing progress if KILL command has been issued
-        std::cout << "\rProgress: " << std::ceil(((scanlines/core_count) / (double) image_height)*100.0) << "%" << std::flush;
+/* Single worker's render loop: keeps claiming (or stealing) tiles from the scheduler until none are left */
+void renderer::st_render_to_mem(image* const pixels, tile_scheduler& tiles, int worker, int spp, a_bool* KILL) const {
+    tile t;
+    while (tiles.next_tile(worker, t)) {
+        if (KILL != nullptr) if (*KILL == true) return;
+        if (wavefront) render_tile_wavefront(pixels, t, spp, KILL);
+        else render_tile(pixels, t, spp, KILL);
+        end_sample_sequence();  // pool threads draw plain PCG32 numbers again outside of tiles
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            path_totals.add(local_paths);
+        }
+        local_paths.clear();
+        tiles.tile_done(t);
     }
+}
+
+/* The renderer's worker pool, created on first use and recreated only if core_count changes */
+thread_pool& renderer::workers() const {
+    if (!pool || pool->size() != std::max(core_count, 1))
+        pool = std::make_unique<thread_pool>(core_count);
+    return *pool;
+}
 
-    // Wait for all threads to finish their renders
-    for (int i = 0; i < core_count; ++i)
-        threads[i].join();
+/* Renders one frame on the worker pool and blocks until it is done, reporting progress every progress_interval seconds */
+void renderer::pool_render(image* const pixels, a_bool* KILL, int frame, int total_frames, render_checkpoint* checkpoint) const {
+    thread_pool& pool = workers();
+    if (records_features()) pixels->aov.allocate();
 
+    // Split the frame into tiles that are handed out to the workers; with a checkpoint, only the tiles it doesn't have yet
+    std::unique_ptr<tile_scheduler> tiles;
+    if (checkpoint != nullptr) {
+        std::vector<int> remaining;
+        checkpoint->restore(*pixels, remaining);
+        tiles = std::make_unique<tile_scheduler>(pixels->width, pixels->height, tile_size, pool.size(), remaining);
+    } else
+        tiles = std::make_unique<tile_scheduler>(pixels->width, pixels->height, tile_size, pool.size());
+    std::shared_future<void> done = pool.run([&](int worker) { st_render_to_mem(pixels, *tiles, worker, samples_per_pixel, KILL); });
+
+    int restored = tiles->grid_size() - tiles->tile_count();
+    render_progress progress = {0.0, 0, tiles->grid_size(), frame, total_frames};
+    auto interval = std::chrono::duration<double>(progress_interval);
+    auto last_checkpoint = Time::now();
+    std::vector<tile> finished;
+    bool all_done;
+    do {
+        all_done = done.wait_for(interval) == std::future_status::ready;
+        progress.tiles_done = restored + tiles->tiles_done();
+        progress.fraction = progress.tiles_done / (double) progress.tile_count;
+        if (progress_callback) progress_callback(progress);
+
+        // Finished tiles go into the checkpoint from this thread, so the workers render on meanwhile
+        if (checkpoint != nullptr && (all_done || duration(Time::now() - last_checkpoint).count() >= checkpoint_interval)) {
+            finished.clear();
+            tiles->take_finished(finished);
+            checkpoint->save(*pixels, finished);
+            last_checkpoint = Time::now();
+        }
+    } while (!all_done);
+}
+
+/* Checkpoint of the render about to start, if checkpoint_file is set; see render_checkpoint */
+std::unique_ptr<render_checkpoint> renderer::open_checkpoint(int total_frames) const {
+    if (checkpoint_file.empty()) return nullptr;
+    auto checkpoint = std::make_unique<render_checkpoint>();
+    if (!checkpoint->open(checkpoint_file, current_settings(), scene_hash, total_frames, resume)) return nullptr;
+    if (checkpoint->resumed())
+        std::cout << "Resuming from checkpoint '" << checkpoint_file << "'" << (total_frames > 1 ? " at frame " + std::to_string(checkpoint->frame()) : "")
+                  << ": " << checkpoint->tiles_done() << " tiles done" << std::endl;
+    return checkpoint;
+}
+
+/* Multi-threaded render to memory location passed in */
+void renderer::mt_render_to_mem(image* const pixels, a_bool* KILL) const {
+    pool_render(pixels, KILL, 0, 1);
+}
 
-    if (RENDER_DONE != nullptr && KILL != nullptr) {
-        if (*KILL != true) { // We only want to add delay after scene has finished rendering; if it has not (window close command issued), do not add delay
-            std::this_thread::sleep_for(80ms); // wit a small amount to allow final pixels to get drawn onto screen
-            *RENDER_DONE = true;
-        } else
-            std::cout << "Render aborted. Exiting." << std::endl;
+/* Renders one frame (samples_per_pixel samples) into pixels, which must be image_width x image_height. Samples are added
+   to whatever pixels' accumulation buffer already holds. */
+void renderer::render_to_image(image& pixels) const {
+    mt_render_to_mem(&pixels, nullptr);
+}
+
+/* Filters the finished frame in pixels (on the worker pool) and resolves the result for display. The raw accumulation is
+   overwritten, so no more samples should be added to pixels afterwards. */
+void renderer::denoise_image(image& pixels) const {
+    if (!pixels.aov.allocated()) {
+        std::cerr << "Not denoising: the image was rendered without feature buffers (turn denoise on before rendering)" << std::endl;
+        pixels.accum.resolve(pixels.pixels, exposure, tone_map);
+        return;
+    }
+    denoise_filter.apply(pixels, pixels.accum, workers());
+    pixels.accum.resolve(pixels.pixels, exposure, tone_map);
+}
+
+/* Renders only the given tiles (indices into the tile_size grid) of the current frame into pixels, clearing them first,
+   and calls tile_finished on the calling thread for each one as it completes. A render farm worker streams its results
+   this way; the tiles come out exactly as they would in a whole-frame render. */
+void renderer::render_tiles(image& pixels, const std::vector<int>& tiles, const std::function<void(const tile&)>& tile_finished) const {
+    thread_pool& pool = workers();
+    tile_scheduler scheduler(pixels.width, pixels.height, tile_size, pool.size(), tiles);
+    for (int index : tiles) {
+        tile t = scheduler.tile_at(index);
+        pixels.clear(t.x0, t.y0, t.x1, t.y1);
     }
+
+    std::shared_future<void> done = pool.run([&](int worker) { st_render_to_mem(&pixels, scheduler, worker, samples_per_pixel, nullptr); });
+    std::vector<tile> finished;
+    bool all_done;
+    do {
+        all_done = done.wait_for(std::chrono::milliseconds(5)) == std::future_status::ready;
+        finished.clear();
+        scheduler.take_finished(finished);
+        for (const tile& t : finished) tile_finished(t);
+    } while (!all_done);
+}
+
+/* Default progress callback: percentage of tiles done, overwritten in place on one console line */
+void print_progress(const render_progress& p) {
+    if (p.total_frames > 1)
+        std::cout << "\rFrame " << p.frame+1 << "/" << p.total_frames << ": ";
+    else
+        std::cout << "\rProgress: ";
+    std::cout << std::ceil(p.fraction*100.0) << "%   " << std::flush;
 }
 
 /* Renders image into a file (multithreaded) */
@@ -86,97 +695,275 @@ void renderer::render_to_file(const std::string filename) const {
     std::cout << "Scene render into file '" << filename << "' started." << std::endl;
     std::cout << "Dimensions: " << image_width << " x " << image_height << std::endl;
 
-    // Create output file stream
-    std::ofstream PPM;
-    PPM.open(filename);
-    PPM << "P3\n" << image_width << ' ' << image_height << "\n255\n";
-
     // Allocate new image
     image* pixels = new image(image_width, image_height);
+    std::unique_ptr<render_checkpoint> checkpoint = open_checkpoint(1);
+    if (checkpoint) checkpoint->start_frame(0, cam);
 
     // Render into memory
     auto start_time = Time::now();
-    mt_render_to_mem(pixels, nullptr, nullptr);
+    pool_render(pixels, nullptr, 0, 1, checkpoint.get());
     print_render_time(Time::now() - start_time, std::cout, 3);
 
-    // Write pixel values from memory into file
-    for (int i = 0; i < image_width*image_height; ++i)
-        write_ARGB8888_PPM(PPM, (*pixels)[i]);
-
-    // Close output file stream
-    PPM.close();
+    save_render(filename, *pixels);
+    if (checkpoint) checkpoint->remove();  // the render is safely in the file now
 
     std::cout << std::endl;  // make space for next render info on screen
 
     delete pixels;
 }
 
-/* Renders scene and shows it in a program window */
-void renderer::render_to_window() const {
+/* Writes a finished render into a file, along with the heatmap & feature images if those are on, denoising it first if that is on */
+void renderer::save_render(const std::string filename, image& pixels) const {
+    if (write_spp_heatmap)
+        write_heatmap(filename_with_suffix(filename, "_spp"), &pixels);
+    if (write_aovs)
+        write_feature_images(filename, &pixels);
+
+    if (denoise) {
+        auto denoise_start = Time::now();
+        denoise_image(pixels);
+        std::cout << "Denoised in " << duration(Time::now() - denoise_start).count() << "s" << std::endl;
+    }
+
+    // Write image from memory into file
+    write_image(filename, pixels);
+}
+
+/* Debug output: image of how many samples each pixel took, from blue (fewest) to red (most) */
+void renderer::write_heatmap(const std::string filename, const image* const pixels) const {
+    int lo = samples_per_pixel, hi = 0;
+    for (int i = 0; i < image_width*image_height; ++i) {
+        lo = std::min(lo, pixels->accum.samples(i));
+        hi = std::max(hi, pixels->accum.samples(i));
+    }
+
+    image heat(image_width, image_height);
+    for (int i = 0; i < image_width*image_height; ++i) {
+        double t = hi > lo ? (pixels->accum.samples(i) - lo) / double(hi - lo) : 0.0;
+        color c = heatmap(t);
+        heat[i] = convert_to_ARGB8888(c);
+        heat.accum.add(i % image_width, i / image_width, c, 1);
+    }
+    write_image(filename, heat);
+
+    std::cout << "Samples per pixel: min " << lo << ", max " << hi << ". Heatmap written to '" << filename << "'." << std::endl;
+}
+
+/* Debug output: the denoiser's feature buffers as <name>_albedo, <name>_normal (mapped from [-1,1] to [0,1]) and
+   <name>_depth (scaled so the farthest hit is white) */
+void renderer::write_feature_images(const std::string filename, const image* const pixels) const {
+    int size = image_width*image_height;
+    double max_depth = 0.0;
+    for (int i = 0; i < size; ++i)
+        max_depth = std::max(max_depth, pixels->aov.mean(i).depth);
+
+    image albedo(image_width, image_height), normal(image_width, image_height), depth(image_width, image_height);
+    for (int i = 0; i < size; ++i) {
+        aov_sample f = pixels->aov.mean(i);
+        int x = i % image_width, y = i / image_width;
+        albedo.accum.add(x, y, f.albedo, 1);
+        normal.accum.add(x, y, 0.5*(f.normal + vec3(1,1,1)), 1);
+        depth.accum.add(x, y, color(max_depth > 0 ? f.depth / max_depth : 0.0), 1);
+    }
+    for (image* img : {&albedo, &normal, &depth})
+        img->accum.resolve(img->pixels, 1.0, tone_mapping::NONE);
+
+    write_image(filename_with_suffix(filename, "_albedo"), albedo);
+    write_image(filename_with_suffix(filename, "_normal"), normal);
+    write_image(filename_with_suffix(filename, "_depth"), depth);
+    std::cout << "Feature buffers written to '" << filename_with_suffix(filename, "_{albedo,normal,depth}") << "'." << std::endl;
+}
+
+/* Renders scene progressively into a program window. One-sample passes are accumulated until samples_per_pixel is reached,
+   and the keyboard & mouse move the camera (see camera_controller; right click focuses on the clicked object, R restarts).
+   Any camera change aborts the pass in flight and restarts accumulation straight away, starting with a quick pass at
+   1/preview_downscale resolution so navigation stays responsive on big scenes. Only tiles that finished since the last
+   update are uploaded to the texture, and the window is presented at most max_fps times a second. With denoise on, every
+   completed pass is shown denoised. */
+void renderer::render_to_window() {
 
     // Print render info
     std::cout << "Scene render into desktop window started." << std::endl;
     std::cout << "Dimensions: " << image_width << " x " << image_height << std::endl;
+    std::cout << "Controls: W/A/S/D/Q/E move, arrows or left-drag orbit, wheel shifts focus, right click focuses on object, R restarts, Esc quits." << std::endl;
 
     // Create window and renderer
     SDL_Init( SDL_INIT_EVERYTHING );
     SDL_Window* window = SDL_CreateWindow( "Raytracing in One Weekend++", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, image_width, image_height, SDL_WINDOW_SHOWN);
-    SDL_Renderer* sdl_renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer* sdl_renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" );  // use linear filtering for scaling
 
-    // Create texture and allocate space in memory for image
+    // Create texture and allocate space in memory for the full resolution image and the low resolution preview
     SDL_Texture* texture = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, image_width, image_height);
-    image* pixels = new image(image_width, image_height);  
+    image pixels(image_width, image_height);
+    if (records_features()) pixels.aov.allocate();
+    image denoised(image_width, image_height);  // display copy of pixels when denoise is on; pixels keeps accumulating
+    image preview(std::max(image_width/preview_downscale, 1), std::max(image_height/preview_downscale, 1));
+    std::vector<Uint32> upscaled(image_width*image_height);
+
+    // Pick up a window render kept in the checkpoint file: its camera and the passes it had completed
+    std::unique_ptr<render_checkpoint> checkpoint = open_checkpoint(0);
+    int restored_passes = 0;
+    if (checkpoint && checkpoint->resumed()) {
+        std::vector<int> remaining;
+        cam = checkpoint->frame_camera();
+        checkpoint->restore(pixels, remaining);
+        restored_passes = checkpoint->passes();
+    }
+    auto last_checkpoint = Time::now();
 
-    // Launch scene render on a separate thread
-    a_bool RENDER_DONE = false;  // flag for stopping rendering pixels from memory to screen once render is finished
-    a_bool KILL = false;  // flag for making the rendering threads stop and return; needed for when user closes the rendering window while render is still in progress
+    camera_controller controller(cam);
+    std::unique_ptr<tile_scheduler> tiles;  // tiles of the pass in flight
+    std::shared_future<void> pass;          // valid while a pass is in flight
+    a_bool KILL = false;                    // makes the workers drop the pass in flight
+    int passes_done = restored_passes;
+    bool need_preview = restored_passes == 0;
+    bool screen_dirty = false;
+    bool timer_done = false;
+    std::vector<tile> finished;
     auto start_time = Time::now();
-    std::thread headless_render(&renderer::mt_render_to_mem, this, pixels, &RENDER_DONE, &KILL);
+    auto last_present = Time::now();
+    const duration present_interval(1.0f / max_fps);
+
+    auto abort_pass = [&] {
+        if (!pass.valid()) return;
+        KILL = true;
+        pass.wait();
+        KILL = false;
+        pass = std::shared_future<void>();
+        tiles.reset();
+    };
+
+    if (restored_passes > 0) {
+        image& shown = denoise ? denoised : pixels;
+        if (denoise) denoise_filter.apply(pixels, denoised.accum, workers());
+        shown.accum.resolve(shown.pixels, exposure, tone_map);
+        SDL_UpdateTexture(texture, nullptr, shown.pixels, image_width*4);
+        screen_dirty = true;
+    }
 
     // Main SDL window loop
     bool running = true;
-    bool timer_done = false;
     while (running) {
-        // Print render time when render is finished
-        if (RENDER_DONE && !timer_done) {
-            print_render_time(Time::now() - start_time, std::cout, 3);
-            timer_done = true;
-        }
 
-        // SDL event handling
+        // SDL event handling; camera moves are applied to a copy, since workers may still be reading cam
+        camera next = cam;
+        bool restart = false;
         SDL_Event e;
-        while(SDL_PollEvent(&e)) { // return 1 if there is a pending event, otherwise 0 (loop doesn't run)
-            if (e.type == SDL_QUIT) {
-                if (RENDER_DONE == false) {
-                    KILL = true;  // send kill command to threads only if render is still in progress
-                    std::cout << std::endl;  // make space for next render info on screen
-                }
+        int pending = (pass.valid() || need_preview) ? SDL_PollEvent(&e) : SDL_WaitEventTimeout(&e, 100);  // sleep while idle
+        while (pending) { // return 1 if there is a pending event, otherwise 0 (loop doesn't run)
+            if (e.type == SDL_QUIT || (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)) {
                 running = false;
                 break;
             }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_r)
+                restart = true;
+            else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_RIGHT) {
+                hit_record rec;
+                ray r = next.get_ray((e.button.x + 0.5) / image_width, (e.button.y + 0.5) / image_height);
+                if (scene_root().hit(r, 0.001, infinity, rec)) {
+                    next.focus(rec.p);
+                    restart = true;
+                }
+            } else if (controller.handle_event(e, next))
+                restart = true;
+            pending = SDL_PollEvent(&e);
         }
+        if (!running) break;
 
-        if (RENDER_DONE == false && running == true) {  // Only continue copying image from memory into texture if render is in progress
-            // Copy pixels from memory into the SDL texture
-            Uint32* locked_pixels = nullptr;
-            int pitch = image_width*4;
-            SDL_LockTexture( texture, nullptr, reinterpret_cast<void**>(&locked_pixels), &pitch );
+        // Restart accumulation from scratch with the new camera
+        if (restart) {
+            abort_pass();
+            cam = next;
+            pixels.clear();
+            passes_done = 0;
+            need_preview = true;
+            timer_done = false;
+            start_time = Time::now();
+        }
 
-            for (int i = 0; i < image_width*image_height; ++i)
-                locked_pixels[i] = (*pixels)[i];
+        // Quick low resolution pass first, so the view follows the camera right away
+        if (need_preview) {
+            preview.clear();
+            tile_scheduler preview_tiles(preview.width, preview.height, tile_size, workers().size());
+            workers().run([&](int worker) { st_render_to_mem(&preview, preview_tiles, worker, 1, nullptr); }).wait();
 
-            SDL_UnlockTexture(texture);
+            for (int y = 0; y < image_height; ++y)
+                for (int x = 0; x < image_width; ++x)
+                    upscaled[y*image_width + x] = preview(std::min(x*preview.width/image_width, preview.width-1),
+                                                          std::min(y*preview.height/image_height, preview.height-1));
+            SDL_UpdateTexture(texture, nullptr, upscaled.data(), image_width*4);
+            screen_dirty = true;
+            need_preview = false;
+        }
+
+        // Upload only the tiles that finished since the last time round
+        bool pass_finished = pass.valid() && pass.wait_for(0s) == std::future_status::ready;
+        if (tiles) {
+            finished.clear();
+            tiles->take_finished(finished);
+            // With denoising on, only the first pass after a restart shows up tile by tile; later ones replace the
+            // denoised frame once they are complete
+            if (denoise && passes_done > 0) finished.clear();
+            for (const tile& t : finished) {
+                SDL_Rect rect = {t.x0, t.y0, t.x1 - t.x0, t.y1 - t.y0};
+                SDL_UpdateTexture(texture, &rect, pixels.pixels + t.y0*image_width + t.x0, image_width*4);
+            }
+            screen_dirty = screen_dirty || !finished.empty();
+        }
+
+        // Keep one full resolution pass in flight until samples_per_pixel is reached
+        if (pass_finished) {
+            pass = std::shared_future<void>();
+            tiles.reset();
+            ++passes_done;
+            if (denoise) {
+                denoise_filter.apply(pixels, denoised.accum, workers());
+                denoised.accum.resolve(denoised.pixels, exposure, tone_map);
+                SDL_UpdateTexture(texture, nullptr, denoised.pixels, image_width*4);
+                screen_dirty = true;
+            }
+            if (checkpoint) {
+                checkpoint->save_pass(pixels, passes_done, cam);
+                if (passes_done == samples_per_pixel || duration(Time::now() - last_checkpoint).count() >= checkpoint_interval) {
+                    checkpoint->write_passes();
+                    last_checkpoint = Time::now();
+                }
+            }
+        }
+        if (!pass.valid() && passes_done < samples_per_pixel) {
+            tiles = std::make_unique<tile_scheduler>(image_width, image_height, tile_size, workers().size());
+            tile_scheduler* pass_tiles = tiles.get();
+            pass = workers().run([this, &pixels, pass_tiles, &KILL](int worker) { st_render_to_mem(&pixels, *pass_tiles, worker, 1, &KILL); });
+        }
 
+        // Print render time when render is finished
+        if (passes_done == samples_per_pixel && !timer_done) {
+            print_render_time(Time::now() - start_time, std::cout, 3);
+            timer_done = true;
+        }
+
+        // Present at most max_fps times a second; otherwise wait for the pass to make progress instead of spinning
+        duration since_present = Time::now() - last_present;
+        if (screen_dirty && since_present >= present_interval) {
             // Copy texture to renderer
             SDL_RenderCopy(sdl_renderer, texture, nullptr, nullptr);
             // Update screen
             SDL_RenderPresent(sdl_renderer);
-        }
+            last_present = Time::now();
+            screen_dirty = false;
+        } else if (pass.valid())
+            pass.wait_for(present_interval - std::min(since_present, present_interval));
     }
 
-    // Join rendering thread
-    headless_render.join();
+    // Stop the pass in flight (if any) before tearing down. The checkpoint only holds whole passes, so it keeps the last
+    // one finished, or none if the camera moved since.
+    abort_pass();
+    if (checkpoint) {
+        if (passes_done == 0) checkpoint->start_frame(0, cam);
+        checkpoint->write_passes();
+    }
 
     SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(sdl_renderer);
@@ -184,25 +971,80 @@ void renderer::render_to_window() const {
     SDL_Quit();
 
     std::cout << std::endl;  // make space for next render info on screen
+}
 
-    delete pixels;
+/* Renders each camera in path as one video frame into output/<frame number>.ppm. Frames go through a pipeline: the
+   renderer's thread pool renders every frame, two image buffers alternate between being rendered into and being written out, and frame N is
+   encoded & written in the background while frame N+1 renders. Leaves cam at the last camera of the path. */
+void renderer::render_frames(const std::vector<camera>& path) {
+    int total_frames = static_cast<int>(path.size());
+    std::cout << "Video render of " << total_frames << " frames started." << std::endl;
+    std::cout << "Dimensions: " << image_width << " x " << image_height << std::endl;
+
+    async_image_writer writer;
+    std::unique_ptr<image> buffers[2] = { std::make_unique<image>(image_width, image_height),
+                                          std::make_unique<image>(image_width, image_height) };
+
+    // A resumed video picks up at the frame in progress; the frames before it are on disk already
+    std::unique_ptr<render_checkpoint> checkpoint = open_checkpoint(total_frames);
+    int first_frame = checkpoint && checkpoint->resumed() ? checkpoint->frame() : 0;
+
+    auto start_time = Time::now();
+    for (int curr_frame = first_frame; curr_frame < total_frames; ++curr_frame) {
+        cam = path[curr_frame];
+        image* pixels = buffers[curr_frame % 2].get();
+        if (checkpoint) checkpoint->start_frame(curr_frame, cam);
+
+        // Render frame N while frame N-1 is still being written from the other buffer
+        pixels->clear();
+        pool_render(pixels, nullptr, curr_frame, total_frames, checkpoint.get());
+        if (denoise) denoise_image(*pixels);
+
+        // Frame N-1 must be on disk before its buffer is reused for frame N+1
+        writer.wait();
+        writer.submit_borrowed("output/" + std::to_string(frame_count + curr_frame) + ".ppm", *pixels);
+        // ...and with a checkpoint, frame N must be on disk before the checkpoint moves on to frame N+1
+        if (checkpoint) writer.wait();
+    }
+    writer.wait();
+    if (checkpoint) checkpoint->remove();
+    frame_count += total_frames;
+
+    duration render_time = Time::now() - start_time;
+    print_render_time(render_time, std::cout, 3);
+    std::cout << "Average per frame: " << render_time.count() / std::max(total_frames, 1) << "s" << std::endl << std::endl;
 }
 
 /* Renders frames of video where focus smoothly shifts from given startpoint to endpoint throughout the video */
 void renderer::render_shifting_focus(point3 startpoint, point3 endpoint, const video_params& vp) {
+    render_frames(shifting_focus_path(startpoint, endpoint, vp));
+}
+
+/* Renders video frames of camera circling counter-clockwise around a central point (in plane specified by e1 & e2) */
+void renderer::render_spinning_circle(const spinning_circle_params& scp) {
+    render_frames(spinning_circle_path(scp));
+}
+
+/* Renders video frames of camera moving in a straight line from current origin to given endpoint */
+void renderer::render_straight_line(point3 endpoint, const video_params& vp) {
+    render_frames(straight_line_path(endpoint, vp));
+}
+
+std::vector<camera> renderer::shifting_focus_path(point3 startpoint, point3 endpoint, const video_params& vp) const {
     ray focus_line = ray(startpoint, endpoint-startpoint);
     int total_frames = vp.fps*vp.seconds;
 
+    std::vector<camera> path;
+    camera c = cam;
     for (int curr_frame = 0; curr_frame < total_frames; ++curr_frame) {
         double progress = (((double)(curr_frame))/total_frames);
-        cam.focus(focus_line.at(progress));
-        render_to_file("output/" + std::to_string(frame_count + curr_frame) + ".ppm");
+        c.focus(focus_line.at(progress));
+        path.push_back(c);
     }
-    frame_count += total_frames;
+    return path;
 }
 
-/* Renders video frames of camera circling counter-clockwise around a central point (in plane specified by e1 & e2) */
-void renderer::render_spinning_circle(const spinning_circle_params& scp) {
+std::vector<camera> renderer::spinning_circle_path(const spinning_circle_params& scp) const {
     vec3 up = cross(scp.e1, scp.e2);
     vec3 r = cam.origin - scp.center;
     vec3 x_hat = unit_vector(r);
@@ -211,27 +1053,29 @@ void renderer::render_spinning_circle(const spinning_circle_params& scp) {
     double radius = r.length();
     int total_frames = scp.vp.fps*scp.vp.seconds;
 
+    std::vector<camera> path;
+    camera c = cam;
     for (int curr_frame = 0; curr_frame < total_frames; ++curr_frame) {
         double circle_prog = ((double)curr_frame)/total_frames;
         double angle = circle_prog*(scp.radians);
-        cam.orient(scp.center + (radius*std::cos(angle)*x_hat + radius*std::sin(angle)*y_hat), scp.center, up);
-        render_to_file("output/" + std::to_string(frame_count + curr_frame) + ".ppm");
+        c.orient(scp.center + (radius*std::cos(angle)*x_hat + radius*std::sin(angle)*y_hat), scp.center, up);
+        path.push_back(c);
     }
-    frame_count += total_frames;
+    return path;
 }
 
-/* Renders video frames of camera moving in a straight line from current origin to given endpoint */
-void renderer::render_straight_line(point3 endpoint, const video_params& vp) {
+std::vector<camera> renderer::straight_line_path(point3 endpoint, const video_params& vp) const {
     vec3 path_vector = endpoint - cam.origin;
-    ray path_ray = ray(cam.origin, path_vector);
     double path_length = path_vector.length();
 
     int total_frames = vp.fps*vp.seconds;
     double pan_amount_per_frame = path_length/total_frames;
 
+    std::vector<camera> path;
+    camera c = cam;
     for (int curr_frame = 0; curr_frame < total_frames; ++curr_frame) {
-        cam.pan(path_vector, pan_amount_per_frame);
-        render_to_file("output/" + std::to_string(frame_count + curr_frame) + ".ppm");
+        c.pan(path_vector, pan_amount_per_frame);
+        path.push_back(c);
     }
-    frame_count += total_frames;
-}
\ No newline at end of file
+    return path;
+}
@@ -2,12 +2,23 @@
 
 #include <thread>
 #include <atomic>
+#include <mutex>
 
 #include "../camera/camera.h"
 #include "../hittable/hittable.h"
 #include "../material/material.h"
 #include "../hittable/hittable_list/hittable_list.h"
+#include "../hittable/bvh_node/bvh_node.h"
+#include "../hittable/sphere_soa/sphere_soa.h"
+#include "../hittable/light_list/light_list.h"
 #include "../image/image.h"
+#include "../image/image_writer/image_writer.h"
+#include "tile_scheduler/tile_scheduler.h"
+#include "thread_pool/thread_pool.h"
+#include "camera_controller/camera_controller.h"
+#include "denoiser/denoiser.h"
+
+class render_checkpoint;
 
 struct video_params{
   int seconds;
@@ -23,6 +34,57 @@ struct spinning_circle_params {
   video_params vp;
 };
 
+/* Passed to renderer::progress_callback while a frame renders */
+struct render_progress {
+  double fraction;   // tiles_done / tile_count
+  int tiles_done;
+  int tile_count;
+  int frame;         // index of the frame being rendered, within total_frames (video renders)
+  int total_frames;
+};
+
+void print_progress(const render_progress& p);
+
+/* Rays traced by a renderer since its counters were last reset */
+struct ray_stats {
+  uint64_t primary;    // camera rays
+  uint64_t secondary;  // scattered (bounce) rays
+  uint64_t shadow;     // light sampling visibility rays
+};
+
+/* Where paths end, per bounce, since the renderer's counters were last reset. For tuning bounce_depth and Russian roulette. */
+struct path_stats {
+  std::vector<uint64_t> rays;      // rays traced at each bounce; bounce 0 are the camera rays
+  std::vector<uint64_t> escaped;   // paths that left the scene at each bounce
+  std::vector<uint64_t> roulette;  // paths ended by Russian roulette after each bounce
+  uint64_t depth_limited = 0;      // paths cut off by bounce_depth
+  uint64_t shadow_rays = 0;
+
+  void count(std::vector<uint64_t>& counter, int bounce, uint64_t n = 1);
+  void add(const path_stats& other);
+  void clear();
+};
+
+/* The settings that decide what a render's pixels come out as, in a fixed layout for render farm messages & checkpoints */
+struct render_settings {
+  int32_t image_width, image_height;
+  int32_t samples_per_pixel, min_samples_per_pixel;
+  int32_t bounce_depth, roulette_depth;
+  int32_t tile_size, wavefront_batch;
+  int32_t adaptive_sampling, next_event_estimation, wavefront, sampling;
+  int32_t features, padding;  // features: images carry denoiser feature planes (see renderer::records_features())
+  double adaptive_threshold, roulette_threshold;
+  double background[3];
+  uint64_t seed;
+};
+
+/* The surface a path scattered from last, for weighting light it finds against light sampling */
+struct path_vertex {
+  point3 p;
+  double pdf;     // density with which the scattered direction was picked
+  bool specular;  // no density (mirror, glass, or the camera), so light sampling couldn't have picked it
+};
+
 class renderer {
   public:
     typedef std::atomic<bool> a_bool;
@@ -30,24 +92,93 @@ class renderer {
 
     renderer();
 
-    void render_to_file(const std::string filename) const;
-    void render_to_window() const;
+    void render_to_file(const std::string filename) const;  // format picked by extension: .ppm (binary P6), .pfm (float HDR), .png
+    void render_to_image(image& pixels) const;  // adds one frame of samples to pixels' accumulation buffer, no file output
+    void denoise_image(image& pixels) const;    // replaces pixels' accumulated radiance with denoise_filter's output and resolves it
+    void save_render(const std::string filename, image& pixels) const;  // the file output of render_to_file, for a frame rendered elsewhere
+    void render_to_window();
     void render_shifting_focus(point3 startpoint, point3 endpoint, const video_params& vp);
     void render_spinning_circle(const spinning_circle_params& scp);
     void render_straight_line(point3 endpoint, const video_params& vp);
+    void render_frames(const std::vector<camera>& path);
+    void render_tiles(image& pixels, const std::vector<int>& tiles, const std::function<void(const tile&)>& tile_finished) const;
+
+    // Camera paths of the video helpers above, starting from cam, one camera per frame
+    std::vector<camera> shifting_focus_path(point3 startpoint, point3 endpoint, const video_params& vp) const;
+    std::vector<camera> spinning_circle_path(const spinning_circle_params& scp) const;
+    std::vector<camera> straight_line_path(point3 endpoint, const video_params& vp) const;
+    render_settings current_settings() const;
+    void apply_settings(const render_settings& s);
+    bool records_features() const;  // denoise || write_aovs
+    void build_bvh();
+    void build_lights();
+    bool enable_packet_tracing();
+    ray_stats ray_counts() const;
+    path_stats path_counts() const;
+    void reset_ray_counts();
 
   private:
-    pixel ray_color(const ray& r, int depth) const;
-    void st_render_to_mem(image* const pixels, a_int& scanlines, a_bool* KILL) const;
-    void mt_render_to_mem(image* const pixels, a_bool* RENDER_DONE, a_bool* KILL) const;
+    pixel ray_color(ray r, int depth, const hit_record* first_hit = nullptr, aov_sample* features = nullptr) const;
+    bool survives_roulette(color& throughput, int bounce) const;
+    double emission_weight(const path_vertex& prev, const hit_record& rec) const;
+    bool sample_light(const hit_record& rec, ray& shadow, double& t_max, color& contribution) const;
+    bool unoccluded(const ray& shadow, double t_max) const;
+    pixel miss_color(const ray& r) const;
+    bool record_features(aov_sample& f, const ray& r, const hit_record* rec, const color& throughput, int bounce) const;
+    void start_sample(int index, int sample) const;
+    ray camera_ray(int j, int i, int width, int height) const;
+    void trace_samples(int j, int i, int width, int height, int first_sample, int count, color* samples, aov_sample* features) const;
+    const hittable& scene_root() const;
+    bool pixel_converged(int n, double mean, double m2) const;
+    void render_tile(image* const pixels, const tile& t, int spp, a_bool* KILL) const;
+    void render_tile_wavefront(image* const pixels, const tile& t, int spp, a_bool* KILL) const;
+    void st_render_to_mem(image* const pixels, tile_scheduler& tiles, int worker, int spp, a_bool* KILL) const;
+    void mt_render_to_mem(image* const pixels, a_bool* KILL) const;
+    void pool_render(image* const pixels, a_bool* KILL, int frame, int total_frames, render_checkpoint* checkpoint = nullptr) const;
+    std::unique_ptr<render_checkpoint> open_checkpoint(int total_frames) const;
+    thread_pool& workers() const;
+    void write_heatmap(const std::string filename, const image* const pixels) const;
+    void write_feature_images(const std::string filename, const image* const pixels) const;
     int frame_count;
+    mutable std::unique_ptr<thread_pool> pool;  // persistent workers shared by all renders
+    mutable std::mutex stats_mutex;
+    mutable path_stats path_totals;  // per-thread counts are flushed in here after every tile
 
   public:  // perhaps make a bunch of these private and set them in the constructor
     hittable_list world;
+    hittable::ptr world_root;  // traced instead of world if set: a bvh_node (see build_bvh()) or a flat sphere_soa copy of world
+    std::shared_ptr<sphere_soa> packet_scene;  // SoA copy of world for packet-traced primary rays (see enable_packet_tracing())
+    light_list lights;            // emissive spheres of world (see build_lights())
     camera cam;
     int image_width;
     int image_height;
-    int samples_per_pixel;
+    int samples_per_pixel;        // maximum when adaptive_sampling is on
+    bool adaptive_sampling;
+    int min_samples_per_pixel;
+    double adaptive_threshold;    // relative 95% confidence interval at which a pixel stops sampling
+    bool write_spp_heatmap;       // render_to_file also writes <name>_spp.<ext> showing samples taken per pixel
+    bool write_aovs;              // render_to_file also writes the denoiser's guides as <name>_albedo/_normal/_depth.<ext>
+    bool denoise;                 // run denoise_filter over finished frames (files, video frames and completed window passes)
+    denoiser denoise_filter;
     int bounce_depth;
+    int roulette_depth;           // bounces before Russian roulette may end a path
+    double roulette_threshold;    // paths whose throughput falls below this survive with probability throughput/threshold
+    color background;             // radiance of rays that leave the scene
+    bool next_event_estimation;   // sample lights directly at diffuse hits, MIS-weighted against scattering into them
+    bool wavefront;               // trace each tile breadth-first in material-sorted batches (see render_tile_wavefront())
+    int wavefront_batch;          // paths in flight per worker with wavefront on
     int core_count;
+    int tile_size;
+    std::function<void(const render_progress&)> progress_callback;  // called from the rendering thread; print_progress by default
+    double progress_interval;     // seconds between progress_callback calls
+    double exposure;              // linear scale applied when resolving accumulated radiance for display
+    tone_mapping tone_map;
+    int max_fps;                  // render_to_window present rate cap
+    int preview_downscale;        // render_to_window shows a 1/preview_downscale resolution pass first after each camera move
+    sample_pattern sampling;      // SOBOL: each pixel's samples are points of its own scrambled Sobol sequence (see start_sample())
+    std::string checkpoint_file;  // if set, file, video & window renders keep their progress in this file (see render_checkpoint)
+    double checkpoint_interval;   // seconds between checkpoint updates
+    bool resume;                  // continue the render saved in checkpoint_file, if it is of the same settings & scene
+    uint64_t scene_hash;          // identifies the scene in checkpoint files (see scene_hash()); 0 if unknown
+    uint64_t seed;  // base seed; each pixel's samples are drawn from a stream seeded by (seed, pixel index)
 };
@@ -0,0 +1,69 @@
+#include "thread_pool.h"
+
+thread_pool::thread_pool(int thread_count): generation(0), active(0), stopping(false) {
+  if (thread_count < 1) thread_count = 1;
+  for (int i = 0; i < thread_count; ++i)
+    workers.emplace_back(&thread_pool::worker_loop, this, i);
+}
+
+thread_pool::~thread_pool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(m);
+    stopping = true;
+  }
+  job_ready.notify_all();
+  for (std::thread& t : workers)
+    t.join();
+}
+
+std::shared_future<void> thread_pool::run(const std::function<void(int)>& job) {
+  wait();  // one job at a time
+  std::shared_future<void> done;
+  {
+    std::lock_guard<std::mutex> lock(m);
+    current_job = job;
+    active = static_cast<int>(workers.size());
+    ++generation;
+    job_promise = std::promise<void>();
+    done = job_promise.get_future().share();
+  }
+  job_ready.notify_all();
+  return done;
+}
+
+void thread_pool::wait() {
+  std::unique_lock<std::mutex> lock(m);
+  job_done.wait(lock, [this] { return active == 0; });
+}
+
+bool thread_pool::wait_for(duration timeout) {
+  std::unique_lock<std::mutex> lock(m);
+  return job_done.wait_for(lock, timeout, [this] { return active == 0; });
+}
+
+int thread_pool::size() const {
+  return static_cast<int>(workers.size());
+}
+
+void thread_pool::worker_loop(int index) {
+  unsigned long seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m);
+      job_ready.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+    }
+
+    current_job(index);  // not modified while active > 0, since run() waits for the previous job first
+
+    {
+      std::lock_guard<std::mutex> lock(m);
+      if (--active == 0) {
+        job_promise.set_value();
+        job_done.notify_all();
+      }
+    }
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+
+/* Fixed set of long-lived worker threads. run() hands the same job to every worker (each gets its own worker index) and
+   returns immediately with a future that becomes ready once all of them have finished it; wait() blocks until then. Idle workers sleep on a condition variable,
+   so keeping a pool around between renders costs nothing, and starting a render costs no thread spawns. */
+class thread_pool {
+  public:
+    thread_pool(int thread_count);
+    ~thread_pool();
+
+    std::shared_future<void> run(const std::function<void(int)>& job);
+    void wait();
+    bool wait_for(duration timeout);  // returns true if the job finished within the timeout
+    int size() const;
+
+  private:
+    void worker_loop(int index);
+
+  private:
+    std::vector<std::thread> workers;
+    std::function<void(int)> current_job;
+    std::mutex m;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+    std::promise<void> job_promise;
+    unsigned long generation;  // bumped by run(); workers use it to tell a new job from one they already did
+    int active;
+    bool stopping;
+};
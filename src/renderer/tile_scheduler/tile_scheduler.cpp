@@ -0,0 +1,80 @@
+#include "tile_scheduler.h"
+
+#include <algorithm>
+
+tile_scheduler::tile_scheduler(int w, int h, int ts, int wc): width(w), height(h), tile_size(ts), worker_count(wc), completed(0) {
+  if (tile_size < 1) tile_size = 1;
+  if (worker_count < 1) worker_count = 1;
+
+  tiles_x = (width + tile_size - 1) / tile_size;
+  int tiles_y = (height + tile_size - 1) / tile_size;
+  grid_tiles = tiles_x * tiles_y;
+  total_tiles = grid_tiles;
+  split_ranges();
+}
+
+tile_scheduler::tile_scheduler(int w, int h, int ts, int wc, const std::vector<int>& tiles): tile_scheduler(w, h, ts, wc) {
+  subset = tiles;
+  total_tiles = static_cast<int>(subset.size());
+  split_ranges();
+}
+
+/* Divides the tiles into near-equal contiguous ranges, one per worker */
+void tile_scheduler::split_ranges() {
+  ranges.reset(new tile_range[worker_count]);
+  for (int i = 0; i < worker_count; ++i) {
+    ranges[i].next = (int)((long long)total_tiles * i / worker_count);
+    ranges[i].end  = (int)((long long)total_tiles * (i+1) / worker_count);
+  }
+
+  finished.reset(new std::atomic<bool>[grid_tiles]);
+  for (int i = 0; i < grid_tiles; ++i)
+    finished[i] = false;
+}
+
+bool tile_scheduler::next_tile(int worker, tile& t) {
+  // Own range first, then steal from the others in round-robin order starting at the next worker
+  for (int k = 0; k < worker_count; ++k)
+    if (claim((worker + k) % worker_count, t)) return true;
+  return false;
+}
+
+bool tile_scheduler::claim(int owner, tile& t) {
+  tile_range& r = ranges[owner];
+  if (r.next.load(std::memory_order_relaxed) >= r.end) return false;  // skip drained ranges without bumping their counter
+
+  int index = r.next.fetch_add(1, std::memory_order_relaxed);
+  if (index >= r.end) return false;
+
+  t = tile_at(subset.empty() ? index : subset[index]);
+  return true;
+}
+
+tile tile_scheduler::tile_at(int index) const {
+  int x0 = (index % tiles_x) * tile_size;
+  int y0 = (index / tiles_x) * tile_size;
+  return tile{x0, y0, std::min(x0 + tile_size, width), std::min(y0 + tile_size, height), index};
+}
+
+void tile_scheduler::tile_done(const tile& t) {
+  finished[t.index].store(true, std::memory_order_release);
+  completed.fetch_add(1, std::memory_order_release);
+}
+
+void tile_scheduler::take_finished(std::vector<tile>& out) {
+  for (int i = 0; i < grid_tiles; ++i)
+    if (finished[i].load(std::memory_order_relaxed) && finished[i].exchange(false, std::memory_order_acquire))
+      out.push_back(tile_at(i));
+}
+
+int tile_scheduler::tile_count() const {
+  return total_tiles;
+}
+
+int tile_scheduler::tiles_done() const {
+  return completed.load(std::memory_order_acquire);
+}
+
+int tile_scheduler::grid_size() const {
+  return grid_tiles;
+}
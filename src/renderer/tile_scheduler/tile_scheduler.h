@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+/* Rectangular block of pixels [x0, x1) x [y0, y1) */
+struct tile {
+  int x0, y0;
+  int x1, y1;
+  int index;  // position in the scheduler's row-major tile grid
+};
+
+/* Splits a frame into square tiles and hands them out to worker threads, so that every pixel is owned by exactly one worker.
+   Each worker starts with a contiguous range of tile indices and claims tiles from it with an atomic fetch_add. Once its own
+   range runs dry it steals from the other workers' ranges the same way. No locks are taken, and no tile is handed out twice.
+   Finished tiles are flagged so that a display thread can pick up just the tiles that changed (take_finished()).
+   A scheduler can also hand out just a subset of the grid, as a render farm worker does with the tiles of one job. */
+class tile_scheduler {
+  public:
+    tile_scheduler(int width, int height, int tile_size, int worker_count);
+    tile_scheduler(int width, int height, int tile_size, int worker_count, const std::vector<int>& subset);  // only these tiles of the grid
+
+    bool next_tile(int worker, tile& t);  // returns false once every tile has been claimed
+    void tile_done(const tile& t);
+    void take_finished(std::vector<tile>& out);  // appends tiles finished since the previous call
+
+    int tile_count() const;
+    int tiles_done() const;
+    int grid_size() const;        // tiles in the whole grid, whether handed out or not
+    tile tile_at(int index) const;  // tile of the grid by row-major index
+
+  private:
+    void split_ranges();
+    bool claim(int owner, tile& t);
+
+    struct alignas(64) tile_range {  // one cache line per worker so that claims don't false-share
+      std::atomic<int> next;
+      int end;
+    };
+
+  private:
+    int width;
+    int height;
+    int tile_size;
+    int tiles_x;
+    int grid_tiles;
+    int total_tiles;          // handed out: grid_tiles, or subset.size()
+    std::vector<int> subset;  // grid indices handed out, if not the whole grid
+    int worker_count;
+    std::unique_ptr<tile_range[]> ranges;
+    std::unique_ptr<std::atomic<bool>[]> finished;
+    std::atomic<int> completed;
+};
@@ -0,0 +1,46 @@
+#include "scene_arena.h"
+
+scene_arena::scene_arena(size_t block_size): block_size(block_size), cursor(nullptr), remaining(0), objects(0), used(0) {}
+
+scene_arena::~scene_arena() {
+  clear();
+}
+
+/* Bump allocation out of the newest block. Requests that don't fit start a new block (sized to fit if they're bigger
+   than block_size); the unused tail of the old block is simply left behind. */
+void* scene_arena::allocate(size_t size, size_t alignment) {
+  size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+  if (cursor == nullptr || padding + size > remaining) {
+    size_t bytes = std::max(block_size, size + alignment);
+    blocks.emplace_back(new unsigned char[bytes]);
+    cursor = blocks.back().get();
+    remaining = bytes;
+    padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+  }
+
+  void* p = cursor + padding;
+  cursor += padding + size;
+  remaining -= padding + size;
+  used += size;
+  return p;
+}
+
+/* One-shot teardown: destructors in reverse order of construction, then every block in one go */
+void scene_arena::clear() {
+  for (auto d = destructors.rbegin(); d != destructors.rend(); ++d)
+    d->destroy(d->object);
+  destructors.clear();
+  blocks.clear();
+  cursor = nullptr;
+  remaining = 0;
+  objects = 0;
+  used = 0;
+}
+
+size_t scene_arena::object_count() const {
+  return objects;
+}
+
+size_t scene_arena::bytes_used() const {
+  return used;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <type_traits>
+#include <new>
+#include <algorithm>
+
+/* Owns the objects of a scene (hittables, materials, BVH nodes) in a few large memory blocks. make() constructs an object
+   in place with a bump allocation, so objects never move and never get freed individually: the rest of the scene refers
+   to them through plain non-owning pointers, with no per-object allocation or reference count. clear() (or destroying the
+   arena) runs the destructors that aren't trivial, newest first, and then releases the blocks all at once. */
+class scene_arena {
+  public:
+    typedef std::shared_ptr<scene_arena> ptr;
+
+    scene_arena(size_t block_size = 1 << 20);
+    ~scene_arena();
+
+    scene_arena(const scene_arena&) = delete;
+    scene_arena& operator=(const scene_arena&) = delete;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args);
+
+    void*  allocate(size_t size, size_t alignment);
+    void   clear();
+    size_t object_count() const;
+    size_t bytes_used()   const;
+
+  private:
+    struct destructor {
+      void* object;
+      void (*destroy)(void*);
+    };
+
+  private:
+    std::vector<std::unique_ptr<unsigned char[]>> blocks;
+    std::vector<destructor> destructors;  // only for types that need one
+    size_t block_size;
+    unsigned char* cursor;  // next free byte in the newest block
+    size_t remaining;       // bytes left after cursor in the newest block
+    size_t objects;
+    size_t used;
+};
+
+template <typename T, typename... Args>
+T* scene_arena::make(Args&&... args) {
+  T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  if (!std::is_trivially_destructible<T>::value)
+    destructors.push_back({object, [](void* p) { static_cast<T*>(p)->~T(); }});
+  ++objects;
+  return object;
+}
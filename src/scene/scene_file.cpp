@@ -0,0 +1,444 @@
+#include "scene_file.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+#include "../hittable/sphere/sphere.h"
+#include "../material/matte/matte.h"
+#include "../material/metal/metal.h"
+#include "../material/dielectric/dielectric.h"
+#include "../material/emissive/emissive.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(scene_file_header) == 176, "scene_file_header must have no padding");
+static_assert(sizeof(scene_file_material) == 52, "scene_file_material must have no padding");
+static_assert(sizeof(scene_file_sphere) == 20, "scene_file_sphere must have no padding");
+
+static const char scene_magic[8] = {'R', 'T', 'W', 'S', 'C', 'E', 'N', 'E'};
+static const uint32_t scene_version = 2;
+
+/* The binary form is little-endian; big-endian hosts swap every field on the way in and out */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static const bool host_big_endian = true;
+#else
+static const bool host_big_endian = false;
+#endif
+
+template <class T>
+static void swap_bytes(T& value) {
+  char* bytes = reinterpret_cast<char*>(&value);
+  std::reverse(bytes, bytes + sizeof(T));
+}
+
+template <class T, size_t N>
+static void swap_bytes(T (&values)[N]) {
+  for (T& v : values) swap_bytes(v);
+}
+
+static void little_endian(scene_file_header& h) {
+  if (!host_big_endian) return;
+  swap_bytes(h.version);
+  swap_bytes(h.material_count);
+  swap_bytes(h.sphere_count);
+  swap_bytes(h.image_width);
+  swap_bytes(h.image_height);
+  swap_bytes(h.samples_per_pixel);
+  swap_bytes(h.bounce_depth);
+  swap_bytes(h.camera);
+  swap_bytes(h.background);
+}
+
+static void little_endian(scene_file_material& m) {
+  if (!host_big_endian) return;
+  swap_bytes(m.type);
+  swap_bytes(m.params);
+}
+
+static void little_endian(scene_file_sphere& s) {
+  if (!host_big_endian) return;
+  swap_bytes(s.center);
+  swap_bytes(s.radius);
+  swap_bytes(s.material);
+}
+
+/* Read-only view of a whole file: memory-mapped where possible, otherwise read into a buffer */
+class mapped_file {
+  public:
+    mapped_file(const std::string& filename) {
+#ifndef _WIN32
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0) return;
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+          madvise(p, st.st_size, MADV_SEQUENTIAL);
+          mapping = p;
+          bytes = static_cast<const char*>(p);
+          length = st.st_size;
+        }
+      }
+      close(fd);
+      if (mapping) {
+        found = true;
+        return;
+      }
+#endif
+      std::ifstream file(filename, std::ios::binary);
+      if (!file) return;
+      buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+      bytes = buffer.data();
+      length = buffer.size();
+      found = true;
+    }
+
+    ~mapped_file() {
+#ifndef _WIN32
+      if (mapping) munmap(mapping, length);
+#endif
+    }
+
+    bool ok() const { return found; }
+    const char* begin() const { return bytes; }
+    const char* end() const { return bytes + length; }
+    size_t size() const { return length; }
+
+  private:
+    void* mapping = nullptr;
+    std::vector<char> buffer;
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool found = false;
+};
+
+scene_description::scene_description(): arena(std::make_shared<scene_arena>()), world(arena) {}
+
+int scene_description::height() const {
+  return image_height > 0 ? image_height : static_cast<int>(image_width / (16.0/9.0));
+}
+
+camera scene_description::make_camera() const {
+  return camera(cam.lookfrom, cam.lookat, cam.focusat, cam.vup, double(image_width) / height(), cam.vfov, cam.aperture);
+}
+
+/*
+=======================================
+    Text form
+=======================================
+*/
+
+/* Cursor over one line of a text scene file */
+struct line_reader {
+  const char* p;
+  const char* end;
+
+  void skip_space() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+  }
+
+  bool at_end() {
+    skip_space();
+    return p == end || *p == '#';
+  }
+
+  bool word(std::string& out) {
+    skip_space();
+    const char* start = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') ++p;
+    out.assign(start, p);
+    return p > start;
+  }
+
+  bool number(double& out) {
+    skip_space();
+    if (p < end && *p == '+') ++p;  // from_chars doesn't accept a leading '+'
+    auto result = std::from_chars(p, end, out);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+  }
+
+  bool number(int& out) {
+    double d;
+    if (!number(d)) return false;
+    out = static_cast<int>(d);
+    return true;
+  }
+
+  bool vector(vec3& out) {
+    double x, y, z;
+    if (!number(x) || !number(y) || !number(z)) return false;
+    out = vec3(x, y, z);
+    return true;
+  }
+};
+
+/* Name of the first of scene's render options that is out of range (a height of 0 is the 16:9 default), or nullptr */
+static const char* bad_render_option(const scene_description& scene) {
+  if (scene.image_width <= 0) return "width";
+  if (scene.image_height < 0) return "height";
+  if (scene.samples_per_pixel <= 0) return "spp";
+  if (scene.bounce_depth <= 0) return "depth";
+  return nullptr;
+}
+
+/* Parses a text scene from [begin, end). Spheres may only use materials declared above them. */
+bool parse_scene_text(const char* begin, const char* end, scene_description& scene, const std::string& source) {
+  std::unordered_map<std::string, const material*> material_names;
+  for (const auto& m : scene.materials) material_names[m.first] = m.second;
+
+  int line_number = 0;
+  std::string keyword, name, type;
+  const char* line = begin;
+  while (line < end) {
+    ++line_number;
+    const char* line_end = static_cast<const char*>(memchr(line, '\n', end - line));
+    if (!line_end) line_end = end;
+    line_reader in = {line, line_end};
+    line = line_end + 1;
+
+    if (in.at_end()) continue;  // blank line or comment
+    in.word(keyword);
+
+    bool ok = true;
+    if (keyword == "sphere") {
+      vec3 center;
+      double radius;
+      ok = in.vector(center) && in.number(radius) && in.word(name);
+      if (ok) {
+        auto m = material_names.find(name);
+        if (m == material_names.end()) {
+          std::cerr << source << ":" << line_number << ": unknown material '" << name << "'" << std::endl;
+          return false;
+        }
+        scene.world.add(scene.arena->make<sphere>(center, radius, m->second));
+      }
+    } else if (keyword == "material") {
+      ok = in.word(name) && in.word(type);
+      const material* m = nullptr;
+      color albedo;
+      double param;
+      if (ok && type == "matte" && (ok = in.vector(albedo)))
+        m = scene.arena->make<matte>(albedo);
+      else if (ok && type == "metal" && (ok = in.vector(albedo) && in.number(param)))
+        m = scene.arena->make<metal>(albedo, param);
+      else if (ok && type == "dielectric" && (ok = in.number(param)))
+        m = scene.arena->make<dielectric>(param);
+      else if (ok && type == "emissive" && (ok = in.vector(albedo)))
+        m = scene.arena->make<emissive>(albedo);
+      else if (ok) {
+        std::cerr << source << ":" << line_number << ": unknown material type '" << type << "'" << std::endl;
+        return false;
+      }
+      if (ok) {
+        material_names[name] = m;
+        scene.materials.push_back({name, m});
+      }
+    } else if (keyword == "camera") {
+      camera_params& c = scene.cam;
+      ok = in.vector(c.lookfrom) && in.vector(c.lookat) && in.vector(c.focusat) && in.vector(c.vup)
+        && in.number(c.vfov) && in.number(c.aperture);
+    } else if (keyword == "width")  ok = in.number(scene.image_width);
+    else if (keyword == "height")   ok = in.number(scene.image_height);
+    else if (keyword == "spp")      ok = in.number(scene.samples_per_pixel);
+    else if (keyword == "depth")    ok = in.number(scene.bounce_depth);
+    else if (keyword == "background") ok = in.vector(scene.background);
+    else {
+      std::cerr << source << ":" << line_number << ": unknown statement '" << keyword << "'" << std::endl;
+      return false;
+    }
+
+    if (!ok || !in.at_end()) {
+      std::cerr << source << ":" << line_number << ": malformed '" << keyword << "' statement" << std::endl;
+      return false;
+    }
+    if (const char* option = bad_render_option(scene)) {
+      std::cerr << source << ":" << line_number << ": '" << option << "' out of range" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+=======================================
+    Binary form
+=======================================
+*/
+
+static bool parse_scene_binary(const char* begin, size_t size, scene_description& scene, const std::string& source) {
+  scene_file_header header;
+  if (size < sizeof(header)) {
+    std::cerr << source << ": truncated scene header" << std::endl;
+    return false;
+  }
+  memcpy(&header, begin, sizeof(header));
+  little_endian(header);
+  if (header.version != scene_version) {
+    std::cerr << source << ": unsupported scene file version " << header.version << std::endl;
+    return false;
+  }
+  // The counts decide how far the records below are read, so check them against the size before multiplying them out
+  size_t records = size - sizeof(header);
+  if (header.material_count > records / sizeof(scene_file_material) ||
+      header.sphere_count > (records - header.material_count*sizeof(scene_file_material)) / sizeof(scene_file_sphere)) {
+    std::cerr << source << ": truncated or corrupt scene file (" << header.material_count << " materials and "
+              << header.sphere_count << " spheres don't fit in " << size << " bytes)" << std::endl;
+    return false;
+  }
+
+  scene.image_width = header.image_width;
+  scene.image_height = header.image_height;
+  scene.samples_per_pixel = header.samples_per_pixel;
+  scene.bounce_depth = header.bounce_depth;
+  if (const char* option = bad_render_option(scene)) {
+    std::cerr << source << ": '" << option << "' out of range in the scene header" << std::endl;
+    return false;
+  }
+  const double* c = header.camera;
+  scene.cam = {point3(c[0], c[1], c[2]), point3(c[3], c[4], c[5]), point3(c[6], c[7], c[8]), vec3(c[9], c[10], c[11]), c[12], c[13]};
+  scene.background = color(header.background[0], header.background[1], header.background[2]);
+
+  const char* p = begin + sizeof(header);
+  std::vector<const material*> table;
+  table.reserve(header.material_count);
+  for (uint32_t i = 0; i < header.material_count; ++i, p += sizeof(scene_file_material)) {
+    scene_file_material rec;
+    memcpy(&rec, p, sizeof(rec));
+    little_endian(rec);
+    rec.name[sizeof(rec.name) - 1] = '\0';
+    color albedo(rec.params[0], rec.params[1], rec.params[2]);
+    const material* m;
+    switch (static_cast<material_type>(rec.type)) {
+      case material_type::MATTE:      m = scene.arena->make<matte>(albedo); break;
+      case material_type::METAL:      m = scene.arena->make<metal>(albedo, rec.params[3]); break;
+      case material_type::DIELECTRIC: m = scene.arena->make<dielectric>(rec.params[0]); break;
+      case material_type::EMISSIVE:   m = scene.arena->make<emissive>(albedo); break;
+      default:
+        std::cerr << source << ": unknown material type " << rec.type << std::endl;
+        return false;
+    }
+    table.push_back(m);
+    scene.materials.push_back({rec.name, m});
+  }
+
+  scene.world.h_list.reserve(scene.world.h_list.size() + header.sphere_count);
+  for (uint64_t i = 0; i < header.sphere_count; ++i, p += sizeof(scene_file_sphere)) {
+    scene_file_sphere rec;
+    memcpy(&rec, p, sizeof(rec));
+    little_endian(rec);
+    if (rec.material >= table.size()) {
+      std::cerr << source << ": sphere " << i << " uses material " << rec.material << " of " << table.size() << std::endl;
+      return false;
+    }
+    scene.world.add(scene.arena->make<sphere>(point3(rec.center[0], rec.center[1], rec.center[2]), rec.radius, table[rec.material]));
+  }
+  return true;
+}
+
+/* Loads a text or binary scene file into scene (on top of whatever it already holds) */
+bool load_scene(const std::string& filename, scene_description& scene) {
+  mapped_file file(filename);
+  if (!file.ok()) {
+    std::cerr << "Could not open scene file '" << filename << "'" << std::endl;
+    return false;
+  }
+  return parse_scene(file.begin(), file.size(), scene, filename);
+}
+
+/* Parses the contents of a text or binary scene file, e.g. one sent to a render farm worker */
+bool parse_scene(const char* begin, size_t size, scene_description& scene, const std::string& source) {
+  if (size >= sizeof(scene_magic) && memcmp(begin, scene_magic, sizeof(scene_magic)) == 0)
+    return parse_scene_binary(begin, size, scene, source);
+  return parse_scene_text(begin, begin + size, scene, source);
+}
+
+uint64_t scene_hash(const char* begin, size_t size) {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < size; ++i) {
+    h ^= static_cast<unsigned char>(begin[i]);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/* Writes scene in the binary form. Only spheres (and matte/metal/dielectric/emissive materials) can be stored. */
+bool write_scene_binary(const std::string& filename, const scene_description& scene) {
+  std::unordered_map<const material*, uint32_t> material_index;
+  std::vector<char> out;
+  scene_file_header header;
+  memcpy(header.magic, scene_magic, sizeof(scene_magic));
+  header.version = scene_version;
+  header.material_count = scene.materials.size();
+  header.sphere_count = scene.world.h_list.size();
+  header.image_width = scene.image_width;
+  header.image_height = scene.image_height;
+  header.samples_per_pixel = scene.samples_per_pixel;
+  header.bounce_depth = scene.bounce_depth;
+  const camera_params& c = scene.cam;
+  double cam[14] = {c.lookfrom.x(), c.lookfrom.y(), c.lookfrom.z(), c.lookat.x(), c.lookat.y(), c.lookat.z(),
+                    c.focusat.x(), c.focusat.y(), c.focusat.z(), c.vup.x(), c.vup.y(), c.vup.z(), c.vfov, c.aperture};
+  memcpy(header.camera, cam, sizeof(cam));
+  for (int k = 0; k < 3; ++k) header.background[k] = scene.background[k];
+
+  out.resize(sizeof(header) + header.material_count*sizeof(scene_file_material) + header.sphere_count*sizeof(scene_file_sphere));
+  little_endian(header);
+  memcpy(out.data(), &header, sizeof(header));
+  char* p = out.data() + sizeof(header);
+
+  for (const auto& named : scene.materials) {
+    scene_file_material rec = {};
+    strncpy(rec.name, named.first.c_str(), sizeof(rec.name) - 1);
+    const material* m = named.second;
+    if (auto mt = dynamic_cast<const metal*>(m)) {
+      rec.type = static_cast<uint32_t>(material_type::METAL);
+      rec.params[3] = mt->fuzz;
+    } else if (auto d = dynamic_cast<const dielectric*>(m)) {
+      rec.type = static_cast<uint32_t>(material_type::DIELECTRIC);
+      rec.params[0] = d->refractive_index;
+    } else if (auto e = dynamic_cast<const emissive*>(m)) {
+      rec.type = static_cast<uint32_t>(material_type::EMISSIVE);
+      for (int k = 0; k < 3; ++k) rec.params[k] = e->radiance[k];
+    } else if (dynamic_cast<const matte*>(m)) {
+      rec.type = static_cast<uint32_t>(material_type::MATTE);
+    } else {
+      std::cerr << "Material '" << named.first << "' cannot be stored in a binary scene file" << std::endl;
+      return false;
+    }
+    if (rec.type == static_cast<uint32_t>(material_type::MATTE) || rec.type == static_cast<uint32_t>(material_type::METAL))
+      for (int k = 0; k < 3; ++k) rec.params[k] = m->albedo[k];
+    material_index.emplace(m, material_index.size());
+    little_endian(rec);
+    memcpy(p, &rec, sizeof(rec));
+    p += sizeof(rec);
+  }
+
+  for (const hittable* h_object : scene.world.h_list) {
+    const sphere* s = dynamic_cast<const sphere*>(h_object);
+    auto m = s ? material_index.find(s->material_ptr) : material_index.end();
+    if (m == material_index.end()) {
+      std::cerr << "Binary scene files can only hold spheres with declared materials" << std::endl;
+      return false;
+    }
+    scene_file_sphere rec = {{float(s->center.x()), float(s->center.y()), float(s->center.z())}, float(s->radius), m->second};
+    little_endian(rec);
+    memcpy(p, &rec, sizeof(rec));
+    p += sizeof(rec);
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  file.write(out.data(), out.size());
+  if (!file) {
+    std::cerr << "Could not write scene file '" << filename << "'" << std::endl;
+    return false;
+  }
+  return true;
+}
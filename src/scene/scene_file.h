@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+
+#include "../camera/camera.h"
+#include "../material/material.h"
+#include "../hittable/hittable_list/hittable_list.h"
+#include "scene_arena/scene_arena.h"
+
+/*
+  Scene files declare the camera, named materials, spheres and render settings, so scenes can change without a rebuild.
+
+  Text form (one statement per line, '#' starts a comment):
+    width    1280                       image size; height defaults to width * 9/16
+    height   720
+    spp      10                         samples per pixel
+    depth    50                         bounce depth
+    background <r g b>                  radiance of rays leaving the scene (default white)
+    camera   <lookfrom> <lookat> <focusat> <vup> <vfov degrees> <aperture>      (points & vectors are 3 numbers each)
+    material <name> matte <r g b>
+    material <name> metal <r g b> <fuzz>
+    material <name> dielectric <refractive index>
+    material <name> emissive <r g b>    light source; radiance can exceed 1
+    sphere   <center> <radius> <material name>
+
+  Binary form, for very large scenes: a scene_file_header followed by material_count scene_file_material records and
+  sphere_count scene_file_sphere records (little-endian, no padding between records). Spheres are stored as floats.
+
+  load_scene() memory-maps the file and tells the two forms apart by the magic number at the start.
+*/
+
+struct camera_params {
+  point3 lookfrom = point3(0, 0, 0);
+  point3 lookat = point3(0, 0, -1);
+  point3 focusat = point3(0, 0, -1);
+  vec3 vup = vec3(0, 1, 0);
+  double vfov = 90;
+  double aperture = 0;
+};
+
+struct scene_description {
+  scene_arena::ptr arena;  // owns the loaded materials and spheres; world and copies of it keep it alive
+  camera_params cam;
+  std::vector<std::pair<std::string, const material*>> materials;  // in declaration order
+  hittable_list world;
+  int image_width = 1280;
+  int image_height = 0;  // 0 = derived from image_width with a 16:9 aspect ratio
+  int samples_per_pixel = 10;
+  int bounce_depth = 50;
+  color background = color(1, 1, 1);
+
+  scene_description();
+
+  int height() const;
+  camera make_camera() const;  // camera with the aspect ratio of the image
+};
+
+bool load_scene(const std::string& filename, scene_description& scene);
+bool parse_scene(const char* begin, size_t size, scene_description& scene, const std::string& source = "scene");  // either form
+bool parse_scene_text(const char* begin, const char* end, scene_description& scene, const std::string& source = "scene");
+bool write_scene_binary(const std::string& filename, const scene_description& scene);
+uint64_t scene_hash(const char* begin, size_t size);  // 64-bit FNV-1a of a scene file's contents, to tell scenes apart
+
+enum class material_type : uint32_t { MATTE = 0, METAL = 1, DIELECTRIC = 2, EMISSIVE = 3 };
+
+struct scene_file_header {
+  char magic[8];            // "RTWSCENE"
+  uint32_t version;
+  uint32_t material_count;
+  uint64_t sphere_count;
+  int32_t image_width, image_height, samples_per_pixel, bounce_depth;
+  double camera[14];        // lookfrom, lookat, focusat, vup, vfov, aperture
+  double background[3];
+};
+
+struct scene_file_material {
+  char name[32];            // null-terminated
+  uint32_t type;            // material_type
+  float params[4];          // matte: r g b; metal: r g b fuzz; dielectric: refractive index; emissive: r g b
+};
+
+struct scene_file_sphere {
+  float center[3];
+  float radius;
+  uint32_t material;        // index into the material records
+};
@@ -16,6 +16,7 @@
 #include <float.h>
 #include <chrono>
 #include <cstdlib>
+#include <cstdint>
 
 /*
 =======================================
@@ -13,4 +13,16 @@ void write_ARGB8888_PPM(std::ofstream& out, const Uint32& ARGB8888) {
   int g = (ARGB8888 & 0x0000FF00) >> 8;
   int b = (ARGB8888 & 0x000000FF);
   out << r << ' ' << g << ' ' << b << '\n';
+}
+
+double luminance(const color& c) {
+  return 0.2126*c.R() + 0.7152*c.G() + 0.0722*c.B();
+}
+
+color heatmap(double t) {
+  t = t < 0 ? 0 : (t > 1 ? 1 : t);
+  double r = std::min(1.0, std::max(0.0, 4.0*t - 2.0));
+  double g = std::min(1.0, std::max(0.0, t < 0.5 ? 4.0*t : 4.0 - 4.0*t));
+  double b = std::min(1.0, std::max(0.0, 2.0 - 4.0*t));
+  return color(r, g, b);
 }
\ No newline at end of file
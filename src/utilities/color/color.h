@@ -8,4 +8,10 @@
 Uint32 convert_to_ARGB8888(const color& pixel_color);
 
 /* Writes ARGB8888 pixel into PPM output file stream */
-void write_ARGB8888_PPM(std::ofstream& out, const Uint32& ARGB8888);
\ No newline at end of file
+void write_ARGB8888_PPM(std::ofstream& out, const Uint32& ARGB8888);
+
+/* Relative luminance (Rec. 709 weights) of a linear RGB color */
+double luminance(const color& c);
+
+/* Maps t in [0,1] onto a blue -> cyan -> green -> yellow -> red ramp, for debug visualizations */
+color heatmap(double t);
\ No newline at end of file
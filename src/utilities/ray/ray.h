@@ -4,15 +4,15 @@
 
 class ray {
   public:
-    ray(const point3& origin, const vec3& direction);
-    ray();
+    constexpr ray(const point3& origin, const vec3& direction): orig(origin), dir(direction) {}
+    constexpr ray() {}
 
-    point3 origin() const;
-    vec3 direction() const;
+    constexpr point3 origin() const { return orig; }
+    constexpr vec3 direction() const { return dir; }
 
-    point3 at(double t) const;   // returns point t units down the ray from the origin
+    constexpr point3 at(real t) const { return orig + t*dir; }   // returns point t units down the ray from the origin
 
   public:
     point3 orig;
     vec3 dir; // unit vector
-};
\ No newline at end of file
+};
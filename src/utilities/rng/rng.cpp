@@ -0,0 +1,36 @@
+#include "rng.h"
+
+pcg32::pcg32() {
+  seed(0x853c49e6748fea9bULL, 0xda3e39cb94b95bdbULL);
+}
+
+pcg32::pcg32(uint64_t initstate, uint64_t stream) {
+  seed(initstate, stream);
+}
+
+void pcg32::seed(uint64_t initstate, uint64_t stream) {
+  state = 0;
+  inc = (stream << 1) | 1;
+  next_uint();
+  state += initstate;
+  next_uint();
+}
+
+uint32_t pcg32::next_uint() {
+  uint64_t oldstate = state;
+  state = oldstate * 6364136223846793005ULL + inc;
+  uint32_t xorshifted = static_cast<uint32_t>(((oldstate >> 18) ^ oldstate) >> 27);
+  uint32_t rot = static_cast<uint32_t>(oldstate >> 59);
+  return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+double pcg32::next_double() {
+  return next_uint() * 0x1p-32;  // 2^-32, so the result is strictly below 1
+}
+
+uint64_t hash64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+/* PCG32 random number generator (O'Neill, pcg-random.org): 64-bit LCG state with a permuted 32-bit output.
+   Small, fast and statistically much better than rand(). Each instance is independent, so one per thread needs no locking. */
+class pcg32 {
+  public:
+    pcg32();
+    pcg32(uint64_t seed, uint64_t stream);
+
+    void     seed(uint64_t seed, uint64_t stream);
+    uint32_t next_uint();
+    double   next_double();  // uniform in [0,1)
+
+  private:
+    uint64_t state;
+    uint64_t inc;  // stream selector; must be odd
+};
+
+/* SplitMix64 finalizer. Turns structured inputs (pixel indices, frame numbers) into well-spread seeds. */
+uint64_t hash64(uint64_t x);
@@ -1,4 +1,7 @@
 #include "rtweekend.h"
+#include "../sampler/sampler.h"
+
+static thread_local sampler thread_sampler;
 
 double degrees_to_radians(double degrees) {
     return degrees * pi / 180.0;
@@ -6,7 +9,7 @@ double degrees_to_radians(double degrees) {
 
 double random_double() {
     // Returns a random real in [0,1).
-    return rand() / (RAND_MAX + 1.0);
+    return thread_sampler.next_1d();
 }
 
 double random_double(double min, double max) {
@@ -14,6 +17,26 @@ double random_double(double min, double max) {
     return min + (max-min)*random_double();
 }
 
+void random_pair(double& u, double& v) {
+    thread_sampler.next_2d(u, v);
+}
+
+void seed_random(uint64_t seed, uint64_t stream) {
+    thread_sampler.seed(seed, stream);
+}
+
+void start_sample_sequence(uint64_t pixel_seed, uint32_t sample_index) {
+    thread_sampler.start_sample(pixel_seed, sample_index);
+}
+
+void end_sample_sequence() {
+    thread_sampler.end_sample();
+}
+
+void start_sample_dimension(uint32_t dimension) {
+    thread_sampler.start_dimension(dimension);
+}
+
 void print_render_time(duration render_time_duration, std::ostream& out, int desired_precision) {
     mins  render_time_mins       = std::chrono::duration_cast<mins>(render_time_duration);
     float render_time_mins_float = float(render_time_mins.count());
@@ -1,7 +1,15 @@
 #pragma once
 
+// Scalar type of the geometry core (vec3, ray, hit_record, camera and the hittables). Configuring with -DRT_USE_FLOAT=ON
+// builds a single precision renderer; everything else (sampling, pdfs, accumulation) keeps its own types.
+#ifdef RT_USE_FLOAT
+typedef float real;
+#else
+typedef double real;
+#endif
+
 // Constants
-const double infinity = std::numeric_limits<double>::infinity();
+const real infinity = std::numeric_limits<real>::infinity();
 const double pi = 3.1415926535897932385;
 
 // Utility Functions
@@ -9,6 +17,19 @@ double degrees_to_radians(double degrees);
 double random_double();
 double random_double(double min, double max);
 
+// Two random numbers in [0,1) meant to be used together (a point on the lens, a direction); with a sample sequence
+// active they are the two coordinates of one stratified 2D point
+void random_pair(double& u, double& v);
+
+// Random numbers are drawn from a per-thread PCG32 generator; seeding it makes the sequence that follows reproducible
+void seed_random(uint64_t seed, uint64_t stream = 0);
+
+// Switches the calling thread's random numbers to the coordinates of sample 'sample_index' of the pixel's scrambled
+// Sobol sequence (see sampler.h), starting at dimension 0, until end_sample_sequence() or the next seed_random()
+void start_sample_sequence(uint64_t pixel_seed, uint32_t sample_index);
+void end_sample_sequence();
+void start_sample_dimension(uint32_t dimension);
+
 // Timer stuff
 typedef std::chrono::high_resolution_clock Time;
 typedef std::chrono::duration<float>       duration;
@@ -0,0 +1,103 @@
+#include "sampler.h"
+
+static uint32_t reverse_bits(uint32_t x) {
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+  x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+/* Laine-Karras style hash with the constants from Burley 2020 ("Practical Hash-based Owen Scrambling"): every bit of the result depends only on
+   the bits below it, so applied to a bit-reversed value it is a nested uniform (Owen) scramble */
+static uint32_t laine_karras(uint32_t x, uint32_t seed) {
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return x;
+}
+
+static uint32_t owen_scramble(uint32_t x, uint32_t seed) {
+  return reverse_bits(laine_karras(reverse_bits(x), seed));
+}
+
+/* Second dimension of the Sobol (0,2)-sequence, generated by the Pascal matrix: direction numbers v_0 = 2^31,
+   v_k = v_{k-1} ^ (v_{k-1} >> 1). The first is van der Corput, reverse_bits(i), which the callers fold into its scramble. */
+struct sobol_directions {
+  uint32_t v[32];
+  constexpr sobol_directions(): v() {
+    v[0] = 0x80000000u;
+    for (int k = 1; k < 32; ++k) v[k] = v[k-1] ^ (v[k-1] >> 1);
+  }
+};
+
+static constexpr sobol_directions directions;
+
+static uint32_t sobol_dimension_1(uint32_t i) {
+  uint32_t x = 0;
+  for (; i != 0; i &= i - 1) x ^= directions.v[__builtin_ctz(i)];
+  return x;
+}
+
+sampler::sampler(): sequence(false), scramble(0), index(0), dimension(0) {}
+
+void sampler::seed(uint64_t seed, uint64_t stream) {
+  rng.seed(seed, stream);
+  sequence = false;
+}
+
+void sampler::start_sample(uint64_t pixel_seed, uint32_t sample_index) {
+  sequence = true;
+  scramble = pixel_seed;
+  index = sample_index;
+  dimension = 0;
+}
+
+void sampler::end_sample() {
+  sequence = false;
+}
+
+void sampler::start_dimension(uint32_t d) {
+  dimension = d;
+}
+
+/* Seeds of dimension d's shuffle of the sample numbers (low half) and of its scramble (high half). Every dimension, or
+   pair of dimensions read by next_2d(), shuffles the sample numbers its own way, which decorrelates it from the rest. */
+uint64_t sampler::dimension_seed(uint32_t d) const {
+  return hash64(scramble ^ hash64(d));
+}
+
+static double to_unit(uint32_t x) {
+  return x * 0x1p-32;
+}
+
+/* Owen-scrambled van der Corput value of shuffled index i: owen_scramble(reverse_bits(i)) with the reversals cancelled */
+static uint32_t scrambled_dimension_0(uint32_t i, uint32_t seed) {
+  return reverse_bits(laine_karras(i, seed));
+}
+
+/* 1D values only need to be stratified in one dimension, so they take the cheap van der Corput component */
+double sampler::next_1d() {
+  if (!sequence) return rng.next_double();
+  uint64_t s = dimension_seed(dimension++);
+  uint32_t i = owen_scramble(index, static_cast<uint32_t>(s));
+  return to_unit(scrambled_dimension_0(i, static_cast<uint32_t>(s >> 32)));
+}
+
+/* Sequence mode skips to the next even dimension and returns both components of one shuffled 2D Sobol point, each
+   Owen-scrambled on its own, so u and v are stratified jointly as well as individually */
+void sampler::next_2d(double& u, double& v) {
+  if (!sequence) {
+    u = rng.next_double();
+    v = rng.next_double();
+    return;
+  }
+  dimension += dimension & 1;
+  uint64_t s = dimension_seed(dimension);
+  uint32_t i = owen_scramble(index, static_cast<uint32_t>(s));
+  u = to_unit(scrambled_dimension_0(i, static_cast<uint32_t>(s >> 32)));
+  v = to_unit(owen_scramble(sobol_dimension_1(i), static_cast<uint32_t>(s >> 32) ^ 0x9e3779b9u));
+  dimension += 2;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../rng/rng.h"
+
+/* Where a pixel sample's random numbers come from */
+enum class sample_pattern {
+  RANDOM,  // independent PCG32 numbers
+  SOBOL    // Owen-scrambled Sobol points, decorrelated between pixels
+};
+
+/* Source of the random numbers behind random_double(). Seeded with seed() it hands out a plain PCG32 stream. After
+   start_sample() it instead hands out the coordinates of one point of a per-pixel low discrepancy sequence: dimension
+   d of sample n comes from the n-th point of an Owen-scrambled Sobol sequence, so the first N samples of a pixel cover
+   every dimension (and every pair read together by next_2d()) far more evenly than N independent random points.
+   Each dimension or pair gets its own independently shuffled copy of the 2D Sobol sequence (Burley 2020, "Practical
+   Hash-based Owen Scrambling"), so there is no limit on how many a path uses. Callers that
+   want the same dimensions to serve the same decision in every sample jump to a fixed dimension with start_dimension(). */
+class sampler {
+  public:
+    sampler();
+
+    void   seed(uint64_t seed, uint64_t stream);                 // PCG32 numbers from here on
+    void   start_sample(uint64_t pixel_seed, uint32_t sample_index);  // sequence numbers from dimension 0 of this sample
+    void   end_sample();                                         // back to PCG32 numbers, carrying on from the last seed()
+    void   start_dimension(uint32_t dimension);                  // no effect on PCG32 numbers
+    double next_1d();
+    void   next_2d(double& u, double& v);                        // both from the same 2D point in sequence mode
+
+  private:
+    uint64_t dimension_seed(uint32_t d) const;
+
+  private:
+    pcg32 rng;
+    bool sequence;
+    uint64_t scramble;   // per-pixel seed of the shuffles & scrambles
+    uint32_t index;      // sample number within the pixel
+    uint32_t dimension;  // next dimension next_1d() returns
+};
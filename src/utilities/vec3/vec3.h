@@ -2,38 +2,41 @@
 
 #include "../rtweekend/rtweekend.h"
 
+/* The vector math is defined inline in this header (constexpr wherever the standard library allows it), so every
+   arithmetic op in the intersection and shading code compiles down to a few instructions in the caller instead of a
+   call into another translation unit. Only the random helpers, which need the per-thread generator, live in vec3.cpp. */
 class vec3 {
   public:
-    vec3(double a, double b, double c);
-    vec3(double d);
-    vec3();
-
-    double x() const;
-    double y() const;
-    double z() const;
-    
-    double R() const;
-    double G() const;
-    double B() const;
+    constexpr vec3(real a, real b, real c): e{a,b,c} {}
+    constexpr vec3(real d): e{d,d,d} {}
+    constexpr vec3(): e{0,0,0} {} // initialize components to 0 if nothing passed in
+
+    constexpr real x() const { return e[0]; }
+    constexpr real y() const { return e[1]; }
+    constexpr real z() const { return e[2]; }
+
+    constexpr real R() const { return e[0]; }
+    constexpr real G() const { return e[1]; }
+    constexpr real B() const { return e[2]; }
 
     /* operators below included as member functions all are concerned with reading/modifying an individual vec3 object. Not concerned with operations *b/w* vec3 objects
        In other words, these are functions you'd call *through* an object. */
 
-    double& operator [] (int i);
-    double  operator [] (int i) const;
-    vec3&   operator += (const vec3& v);
-    vec3&   operator -= (const vec3& v);
-    vec3&   operator *= (double t);
-    vec3&   operator /= (double t);
-    double  length()         const;
-    double  length_squared() const;
-    bool    isUnitVec()      const;
+    constexpr real& operator [] (int i)       { return e[i]; } // if non-const vec3 object, then pass by reference
+    constexpr real  operator [] (int i) const { return e[i]; } // if const vec3 object, then pass by value so that vec3 components do not get modified
+    constexpr vec3& operator += (const vec3& v);
+    constexpr vec3& operator -= (const vec3& v);
+    constexpr vec3& operator *= (real t);
+    constexpr vec3& operator /= (real t);
+    real            length()         const;
+    constexpr real  length_squared() const;
+    bool            isUnitVec()      const;
 
-    inline static vec3 random();
-    inline static vec3 random(double min, double max);
+    static vec3 random();
+    static vec3 random(real min, real max);
 
   public:
-    double e[3];
+    real e[3];
 };
 
 // aliases - same data structure as vec3, just different names
@@ -41,29 +44,111 @@ using point3 = vec3; // 3D point
 using color = vec3;  // RGB color
 using pixel = vec3;
 
+constexpr vec3& vec3::operator+=(const vec3& v) {
+  e[0] += v.e[0];
+  e[1] += v.e[1];
+  e[2] += v.e[2];
+  return *this;
+}
+
+constexpr vec3& vec3::operator-=(const vec3& v) {
+  e[0] -= v.e[0];
+  e[1] -= v.e[1];
+  e[2] -= v.e[2];
+  return *this;
+}
+
+constexpr vec3& vec3::operator*=(real t) {
+  e[0] *= t;
+  e[1] *= t;
+  e[2] *= t;
+  return *this;
+}
+
+constexpr vec3& vec3::operator/=(real t) {
+  return *this *= 1/t;
+}
+
+inline real vec3::length() const {
+  return std::sqrt(length_squared());
+}
+
+constexpr real vec3::length_squared() const {
+  return e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
+}
+
+inline bool vec3::isUnitVec() const {
+  return length() == 1;
+}
+
 // vec3 utility functions, i.e. concerned with operations b/w vec3 objects, and not with modifying/reading an individual object itself.
-inline std::ostream& operator<<(std::ostream& out, const vec3& v);
-
-vec3 operator+ (const vec3& v1, const vec3& v2);
-vec3 operator- (const vec3& v);
-vec3 operator- (const vec3& v1, const vec3& v2);
-vec3 operator* (const vec3& v, double t);
-vec3 operator* (double t, const vec3& v);
-vec3 operator* (const vec3& v1, const vec3& v2);
-vec3 operator/ (const vec3& v1, double t);
-vec3 operator/ (const vec3& v1, int t);
-vec3 operator^ (const vec3& v, double d);
-
-vec3 sqrt(const vec3& v);
-double dot(const vec3& v1, const vec3& v2);
-vec3 cross(const vec3& v1, const vec3& v2);
-vec3 unit_vector(const vec3& v);
 
-point3 random_in_unit_sphere();
-vec3 reflect(const vec3& v_in, const vec3& n);
+inline std::ostream& operator<<(std::ostream& out, const vec3& v) {
+  return out << "[" << v.e[0] << ", " << v.e[1] << ", " << v.e[2] << "]";
+}
+
+constexpr vec3 operator+(const vec3& v1, const vec3& v2) {
+  return vec3(v1.e[0]+v2.e[0], v1.e[1]+v2.e[1], v1.e[2]+v2.e[2]);
+}
+
+constexpr vec3 operator-(const vec3& v) {
+  return vec3(-v.e[0], -v.e[1], -v.e[2]);
+}
+
+constexpr vec3 operator-(const vec3& v1, const vec3& v2) {
+  return v1+(-v2);
+}
 
-double angle_bw(const vec3& v1, const vec3& v2);
+constexpr vec3 operator*(const vec3& v, real t) {
+  return vec3(v.e[0]*t, v.e[1]*t, v.e[2]*t);
+}
 
-vec3 x_hat();
-vec3 y_hat();
-vec3 z_hat();
\ No newline at end of file
+constexpr vec3 operator*(real t, const vec3& v) {
+  return vec3(v.e[0]*t, v.e[1]*t, v.e[2]*t);
+}
+
+constexpr vec3 operator*(const vec3& v1, const vec3& v2) {
+  return vec3(v1.e[0]*v2.e[0], v1.e[1]*v2.e[1], v1.e[2]*v2.e[2]);
+}
+
+constexpr vec3 operator/(const vec3& v1, real t) {
+  return vec3(v1.e[0]/t, v1.e[1]/t, v1.e[2]/t);
+}
+
+inline vec3 operator^(const vec3& v, real d) {
+  return vec3(std::pow(v.e[0], d), std::pow(v.e[1], d), std::pow(v.e[2], d));
+}
+
+inline vec3 sqrt(const vec3& v) {
+  return vec3(std::sqrt(v.e[0]), std::sqrt(v.e[1]), std::sqrt(v.e[2]));
+}
+
+constexpr real dot(const vec3& v1, const vec3& v2) {
+  return v1.e[0]*v2.e[0] + v1.e[1]*v2.e[1] + v1.e[2]*v2.e[2];
+}
+
+constexpr vec3 cross(const vec3& v1, const vec3& v2) {
+  return vec3(v1.e[1] * v2.e[2] - v1.e[2] * v2.e[1],
+              v1.e[2] * v2.e[0] - v1.e[0] * v2.e[2],
+              v1.e[0] * v2.e[1] - v1.e[1] * v2.e[0]);
+}
+
+inline vec3 unit_vector(const vec3& v) {
+  return v / v.length();
+}
+
+constexpr vec3 reflect(const vec3& v_in, const vec3& n) {
+  return v_in - 2*dot(v_in, n)*n;
+}
+
+inline real angle_bw(const vec3& v1, const vec3& v2) {
+  return std::acos( dot(v1, v2) / (v1.length() * v2.length()) );
+}
+
+constexpr vec3 x_hat() { return vec3(1,0,0); }
+constexpr vec3 y_hat() { return vec3(0,1,0); }
+constexpr vec3 z_hat() { return vec3(0,0,1); }
+
+point3 random_in_unit_sphere();
+point3 random_in_unit_disk();
+vec3 random_unit_vector();